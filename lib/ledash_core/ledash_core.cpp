@@ -0,0 +1,988 @@
+// the parts of the dashboard that don't touch the hardware, see ledash_core.h
+
+#include "ledash_core.h"
+
+const StateLookup stateLookup PROGMEM;
+
+// brightness (0..255) of each effect but none for each of the 256 steps of a cycle, generated at compile time
+// all states share one phase, so the effects cost the same lookup for every led and blink in step
+struct EffectTable {
+  uint8_t level[EFFECT_COUNT - 1][256];
+  constexpr EffectTable() : level() {
+    for (int i = 0; i < 256; i++) {
+      level[EFFECT_BLINK - 1][i] = (i < 128) ? 255 : 0;
+      // triangle down and up again, smoothed (3x^2 - 2x^3) so it rests a bit at both ends
+      double x = ((i < 128) ? 127 - i : i - 128) / 127.0;
+      level[EFFECT_PULSE - 1][i] = EFFECT_PULSE_LOW + (255 - EFFECT_PULSE_LOW) * x * x * (3 - 2 * x) + 0.5;
+    }
+  }
+};
+const EffectTable effectTable PROGMEM;
+
+// 255 * (i / 255) ^ (GAMMA / 2) for each of the 256 values, generated at compile time (see buildGammaCurve())
+// there is no constexpr pow(), so it is exp(ln(x) * GAMMA / 2) with both series worked out by the compiler
+struct GammaTable {
+  uint8_t level[256];
+  static constexpr double ln(double x) {
+    // x = m * 2^e with m in 0.5..1, then ln(m) = 2 * atanh((m - 1) / (m + 1)), which converges fast there
+    int e = 0;
+    while (x < 0.5) { x *= 2; e--; }
+    double y = (x - 1) / (x + 1);
+    double sum = 0;
+    double term = y;
+    for (int n = 1; n < 40; n += 2) {
+      sum += term / n;
+      term *= y * y;
+    }
+    return 2 * sum + e * 0.69314718055994531;
+  }
+  static constexpr double exp(double x) {
+    // e^x = (e^(x / 64))^64, the series of such a small x needs only a few terms
+    x /= 64;
+    double sum = 1;
+    double term = 1;
+    for (int n = 1; n < 12; n++) {
+      term *= x / n;
+      sum += term;
+    }
+    for (int n = 0; n < 6; n++) sum *= sum;
+    return sum;
+  }
+  constexpr GammaTable() : level() {
+    for (int i = 1; i < 256; i++) level[i] = 255 * exp(ln(i / 255.0) * GAMMA / 2) + 0.5;
+  }
+};
+const GammaTable gammaTable PROGMEM;
+
+uint8_t* state;
+uint8_t* stateNext;
+uint8_t* statePublished;
+uint16_t* fadeStart;
+uint16_t* expiryHeap;
+uint16_t* expiryIndex;
+uint16_t* expiryDue;
+CRGB* ledsUnmapped;
+CRGB* leds;
+char* statusString;
+uint16_t* mapping;
+uint8_t* heat;
+uint8_t* group;
+uint8_t* slotActive;
+uint8_t* slotFading;
+uint8_t* slotChanged;
+uint16_t led_count = 0;
+uint16_t slot_mask_bytes;
+
+uint8_t brightness_cold = BRIGHTNESS_COLD;
+uint8_t gammaCurve[256];
+uint16_t stateFadeTime[NUM_STATES];
+uint32_t stateFadeRate[NUM_STATES];
+StateEffect stateEffect[NUM_STATES];
+uint8_t effect_phase = 0;
+bool frame_animated = false;
+CHSV stateColor[NUM_STATES];
+CHSV stateColorStaged[NUM_STATES];
+bool palette_staged = false;
+bool mapping_changed = true;
+uint16_t* mappingStaged = NULL;
+bool mapping_staged = false;
+uint8_t memory_level = MEMORY_OK;
+uint16_t expiry_count = 0;
+uint16_t expiry_seconds = 0;
+uint32_t expiry_seconds_last = 0;
+
+// allocates the memory for count leds in one block, so it does not fragment the heap
+// per led this is 5*2 (mapping, fadeStart, expiryHeap, expiryIndex, expiryDue) + 2*3 (ledsUnmapped, leds) + 5 (state,
+// stateNext, statePublished, heat, group) + 1 (statusString) bytes plus 3 bits for the bitmasks = 22.375 bytes
+// (and 12 bytes more for the status string once), with NeoPixelBus there is no leds[], so it is 19.375 bytes
+// not in here: mappingStaged (2 bytes per led), binaryBuffer in src/main.cpp (3 bytes per led + 13 + 4 * NUM_STATES
+// = 309, see binary_capacity) and the buffers of NeoPixelBus (3 bytes per led of pixels, plus 12 per led for DMA or
+// 3 per led for UART1), see the README
+bool allocateLeds(uint16_t count) {
+  uint16_t mask_bytes = (count + 8) / 8;
+  size_t size = count * sizeof(uint16_t)        // mapping comes first because of alignment
+              + 4 * count * sizeof(uint16_t)    // fadeStart, expiryHeap, expiryIndex, expiryDue
+              + (count + 1) * sizeof(CRGB)      // ledsUnmapped
+#ifdef LED_BUFFER
+              + count * sizeof(CRGB)            // leds
+#endif
+              + 5 * count                       // state, stateNext, statePublished, heat, group
+              + 3 * mask_bytes                  // slotActive, slotFading, slotChanged
+              + count + 12;                     // statusString, "<seq>:" fits in front of the states as well
+  uint8_t* p = (uint8_t*) calloc(1, size);
+  if (p == NULL) return false;
+  mapping = (uint16_t*) p;          p += count * sizeof(uint16_t);
+  fadeStart = (uint16_t*) p;        p += count * sizeof(uint16_t);
+  expiryHeap = (uint16_t*) p;       p += count * sizeof(uint16_t);
+  expiryIndex = (uint16_t*) p;      p += count * sizeof(uint16_t);
+  expiryDue = (uint16_t*) p;        p += count * sizeof(uint16_t);
+  ledsUnmapped = (CRGB*) p;         p += (count + 1) * sizeof(CRGB);
+#ifdef LED_BUFFER
+  leds = (CRGB*) p;                 p += count * sizeof(CRGB);
+#endif
+  state = p;                        p += count;
+  stateNext = p;                    p += count;
+  statePublished = p;               p += count;
+  heat = p;                         p += count;
+  group = p;                        p += count;
+  slotActive = p;                   p += mask_bytes;
+  slotFading = p;                   p += mask_bytes;
+  slotChanged = p;                  p += mask_bytes;
+  statusString = (char*) p;
+  memset(expiryIndex, 0xff, count * sizeof(uint16_t));   // NO_EXPIRY
+  led_count = count;
+  slot_mask_bytes = mask_bytes;
+  return true;
+}
+
+// returns the char of state s
+char stateChar(uint8_t s) {
+  return pgm_read_byte(&POSSIBLE_STATES[s]);
+}
+
+// returns the state of char c or -1 if there is no such state
+int16_t stateIndex(char c) {
+  if ((uint8_t) c >= 128) return -1;
+  uint8_t s = pgm_read_byte(&stateLookup.index[(uint8_t) c]);
+  return (s == 0xff) ? -1 : s;
+}
+
+// lets task id run in delay_ms milliseconds (and every interval after that, if it has one)
+void scheduleTask(uint8_t id, uint32_t delay_ms) {
+  tasks[id].due = millis() + delay_ms;
+  tasks[id].pending = true;
+}
+
+// makes sure task id runs within delay_ms milliseconds, an earlier run already pending is kept
+void wakeTask(uint8_t id, uint32_t delay_ms) {
+  if (!tasks[id].pending || ((int32_t) (tasks[id].due - millis()) > (int32_t) delay_ms)) {
+    scheduleTask(id, delay_ms);
+  }
+}
+
+// returns the milliseconds left until interval has passed since last (0 if it has already)
+uint32_t remaining(uint32_t last, uint32_t interval) {
+  uint32_t passed = millis() - last;
+  return (passed >= interval) ? 0 : interval - passed;
+}
+
+// sets the milliseconds a fade to state s takes (half of it fading out the old state, half fading in)
+void setFadeTime(uint8_t s, uint16_t ms) {
+  stateFadeTime[s] = ms;
+  stateFadeRate[s] = (255UL << 16) / (ms / 2);
+}
+
+// returns how far (0..255) the fading out or in of a fade to state s is after elapsed milliseconds
+// only a multiplication and a shift, so it is cheap enough for every slot in every frame
+// elapsed is less than half the fade time (or the fraction is 255 anyway), so this does not overflow
+uint8_t fadeFraction(uint16_t elapsed, uint8_t s) {
+  if (elapsed >= stateFadeTime[s] / 2) return 255;
+  uint32_t f = (elapsed * stateFadeRate[s]) >> 16;
+  return (f > 255) ? 255 : f;
+}
+
+// returns the milliseconds after which fadeFraction() reaches fraction for a fade to state s
+uint16_t fadeElapsed(uint8_t fraction, uint8_t s) {
+  return ((uint32_t) fraction * (stateFadeTime[s] / 2) + 127) / 255;
+}
+
+// starts calculating frames (and cooling) again, unless the self-test still owns the leds
+void wakeFading() {
+  if (tasks[TASK_SELFTEST].pending) return;
+  if (!tasks[TASK_FADING].pending) scheduleTask(TASK_FADING, 0);
+  if (!tasks[TASK_COOLING].pending) scheduleTask(TASK_COOLING, tasks[TASK_COOLING].interval);
+}
+
+// marks a state to be recalculated with the next frames
+void activateSlot(uint16_t position) {
+  slotActive[position >> 3] |= 1 << (position & 7);
+  wakeFading();
+}
+
+// true while state j is fading to stateNext[j]
+bool isFading(uint16_t j) {
+  return slotFading[j >> 3] & (1 << (j & 7));
+}
+
+// marks all states to be recalculated, e.g. if colors or brightness settings changed
+void activateAllSlots() {
+  for (int j=0; j<led_count; j++) {
+    activateSlot(j);
+  }
+}
+
+// returns the palette changes are written to, a copy of stateColor[] which is taken over with the next frame
+// (so a frame never has half of the new colors, however many messages it takes to change them)
+CHSV* stagePalette() {
+  if (!palette_staged) {
+    memcpy(stateColorStaged, stateColor, sizeof(stateColor));
+    palette_staged = true;
+  }
+  wakeFading();
+  return stateColorStaged;
+}
+
+// returns the mapping changes are written to, the same way as stagePalette()
+// if there is no memory for the copy the running mapping is changed right away
+uint16_t* stageMapping() {
+  wakeFading();
+  if (mapping_staged) return mappingStaged;
+  if ((mappingStaged == NULL) && (memory_level == MEMORY_OK)) mappingStaged = (uint16_t*) malloc(led_count * sizeof(uint16_t));
+  if (mappingStaged == NULL) return mapping;
+  memcpy(mappingStaged, mapping, led_count * sizeof(uint16_t));
+  mapping_staged = true;
+  return mappingStaged;
+}
+
+// takes over the staged palette and mapping, this is done between two frames only (see doFading())
+// and before the configuration is written (see saveConfig()), mappingStaged is freed while memory is tight
+void commitStaged() {
+  if (palette_staged) {
+    memcpy(stateColor, stateColorStaged, sizeof(stateColor));
+    palette_staged = false;
+    activateAllSlots();
+  }
+  if (mapping_staged) {
+    memcpy(mapping, mappingStaged, led_count * sizeof(uint16_t));
+    mapping_staged = false;
+    mapping_changed = true;
+  }
+  if ((mappingStaged != NULL) && (memory_level != MEMORY_OK)) {
+    free(mappingStaged);
+    mappingStaged = NULL;
+  }
+}
+
+// builds gammaCurve[] for the overall brightness b, it is only rebuilt when the brightness changes
+// FastLED's hsv2rgb already squares the value (its dimming curve), so the curve adds the rest up to GAMMA
+// with the overall brightness in it the leds get their final bytes, so only the steps of a fade or cool-down
+// which actually change an output byte make it into a frame, at low brightness most of them don't
+// the curve itself is gammaTable, the brightness is folded in with one scale8() per entry and no floats,
+// it is square rooted as hsv2rgb squares it along with the value
+void buildGammaCurve(uint8_t b) {
+  uint8_t scale = sqrt16(b * 255);
+  for (int i = 0; i < 256; i++) {
+    uint8_t v = scale8(pgm_read_byte(&gammaTable.level[i]), scale);
+    gammaCurve[i] = ((i > 0) && (v == 0)) ? 1 : v;     // lit stays lit
+  }
+}
+
+// change the state of a given position to new_state
+// but do nothing if it is already in that state
+// now is the (16 bit) millis() the change is made at, so all changes of one message fade in step
+// returns true if state[] was changed, so the caller knows a status update is due
+bool changeState(uint16_t position, uint8_t new_state, uint16_t now) {
+  if (position < led_count) {
+    activateSlot(position);
+    if (!isFading(position)) {
+      // no fading going on, so let's set the next state and start the fade
+      if (state[position] != new_state) {
+        stateNext[position] = new_state;
+        fadeStart[position] = now;
+        slotFading[position >> 3] |= 1 << (position & 7);
+      }
+    } else {
+      // we are already fading, so let us be careful not to destroy the eye candy smooth fading :-)
+      // the new state may have another fade time, so the start is moved to keep the brightness
+      uint8_t next = stateNext[position];
+      uint16_t elapsed = now - fadeStart[position];
+      uint16_t half = stateFadeTime[next] / 2;
+      if (elapsed < half) {
+        // we are still fading out, so we can just change the next state
+        stateNext[position] = new_state;
+        fadeStart[position] = now - fadeElapsed(fadeFraction(elapsed, next), new_state);
+      } else {
+        // we are already fading in, so we set the next state and inverse the fading
+        uint8_t in = fadeFraction(elapsed - half, next);
+        state[position] = next;
+        stateNext[position] = new_state;
+        fadeStart[position] = now - fadeElapsed(255 - in, new_state);
+        return true;      // we changed state[]
+      }
+    }
+  }
+  return false;
+}
+
+// seconds since boot, only 16 bit so they wrap after 18 hours (which is why TTL_MAX is half of that)
+uint16_t expirySeconds() {
+  uint32_t n = (millis() - expiry_seconds_last) / 1000;
+  expiry_seconds_last += n * 1000;
+  expiry_seconds += n;
+  return expiry_seconds;
+}
+
+// true if slot a expires before slot b
+bool expiresBefore(uint16_t a, uint16_t b) {
+  return (int16_t) (expiryDue[a] - expiryDue[b]) < 0;
+}
+
+// swaps two entries of expiryHeap and keeps expiryIndex up to date
+void expirySwap(uint16_t i, uint16_t j) {
+  uint16_t a = expiryHeap[i];
+  expiryHeap[i] = expiryHeap[j];
+  expiryHeap[j] = a;
+  expiryIndex[expiryHeap[i]] = i;
+  expiryIndex[expiryHeap[j]] = j;
+}
+
+// moves entry i of expiryHeap to where it belongs, up or down
+void expiryRestore(uint16_t i) {
+  while ((i > 0) && expiresBefore(expiryHeap[i], expiryHeap[(i - 1) / 2])) {
+    expirySwap(i, (i - 1) / 2);
+    i = (i - 1) / 2;
+  }
+  while (true) {
+    uint16_t c = 2 * i + 1;
+    if (c >= expiry_count) break;
+    if ((c + 1 < expiry_count) && expiresBefore(expiryHeap[c + 1], expiryHeap[c])) c++;
+    if (!expiresBefore(expiryHeap[c], expiryHeap[i])) break;
+    expirySwap(i, c);
+    i = c;
+  }
+}
+
+// takes slot out of expiryHeap, if it is in there
+void expiryRemove(uint16_t slot) {
+  uint16_t i = expiryIndex[slot];
+  if (i == NO_EXPIRY) return;
+  expiryIndex[slot] = NO_EXPIRY;
+  expiry_count--;
+  if (i < expiry_count) {
+    expiryHeap[i] = expiryHeap[expiry_count];
+    expiryIndex[expiryHeap[i]] = i;
+    expiryRestore(i);
+  }
+}
+
+// lets TASK_EXPIRY run when the first slot in expiryHeap expires
+void scheduleExpiry() {
+  if (expiry_count == 0) {
+    tasks[TASK_EXPIRY].pending = false;
+    return;
+  }
+  int16_t left = expiryDue[expiryHeap[0]] - expirySeconds();
+  scheduleTask(TASK_EXPIRY, (left > 0) ? left * 1000UL : 0);
+}
+
+// sets the time to live of slot to ttl seconds from now, 0 = it doesn't expire
+// only the heap is touched, so this costs log(slots with a time to live) and no scan of all slots
+void setExpiry(uint16_t slot, uint16_t ttl) {
+  if (ttl == 0) {
+    if (expiryIndex[slot] == NO_EXPIRY) return;
+    expiryRemove(slot);
+  } else {
+    expiryDue[slot] = expirySeconds() + ttl;
+    if (expiryIndex[slot] == NO_EXPIRY) {
+      expiryHeap[expiry_count] = slot;
+      expiryIndex[slot] = expiry_count++;
+    }
+    expiryRestore(expiryIndex[slot]);
+  }
+  scheduleExpiry();
+}
+
+// lets all slots whose time to live is over fade to STALE_STATE
+void doExpiry() {
+  uint16_t now = expirySeconds();
+  uint16_t ms = millis();
+  bool changed = false;
+  while ((expiry_count > 0) && ((int16_t) (expiryDue[expiryHeap[0]] - now) <= 0)) {
+    uint16_t slot = expiryHeap[0];
+    expiryRemove(slot);
+    changed |= changeState(slot, stateIndex(STALE_STATE), ms);
+  }
+  if (changed) statusChanged();
+  scheduleExpiry();
+}
+
+// checks and applies the entries of text message v, which are seperated by semicolon
+// entry(p, apply) parses the entry starting at p and returns a pointer to the char behind it (either ';' or the end)
+// or NULL if it is malformed, it only changes something if apply is set
+// all entries are checked first and only then applied, so a malformed message changes nothing at all
+// returns false if the message was rejected
+template <typename Entry>
+bool applyEntries(const char* v, Entry entry) {
+  for (const char* p = v; ; p++) {
+    p = entry(p, false);
+    if (p == NULL) return false;
+    if (*p == 0) break;
+  }
+  for (const char* p = v; ; p++) {
+    p = entry(p, true);
+    if (*p == 0) break;
+  }
+  return true;
+}
+
+// parses one "n=M" pair starting at p (n numeric, M a single char of POSSIBLE_STATES)
+// or "gk=M" for all states of group k (1..GROUPS_MAX), is_group tells which one it was
+// optionally followed by "@ttl", the time to live in seconds (1..TTL_MAX), ttl is 0 without it
+// returns a pointer to the char behind the pair (either ';' or the end of the string)
+// or NULL if the pair is malformed
+const char* parseStatusPair(const char* p, uint16_t &position, bool &is_group, uint8_t &new_state, uint16_t &ttl) {
+  bool g = (*p == 'g');
+  if (g) p++;
+  if (!isDigit(*p)) return NULL;
+  uint32_t v = 0;
+  while (isDigit(*p)) {
+    v = v * 10 + (*p - '0');
+    if (v >= (g ? (uint32_t) GROUPS_MAX + 1 : led_count)) return NULL;
+    p++;
+  }
+  if (g && (v == 0)) return NULL;
+  if (*p != '=') return NULL;
+  p++;
+  if (*p == 0) return NULL;
+  int s = stateIndex(*p);
+  if (s == -1) return NULL;
+  p++;
+  uint32_t t = 0;
+  if (*p == '@') {
+    p++;
+    if (!isDigit(*p)) return NULL;
+    while (isDigit(*p)) {
+      t = t * 10 + (*p - '0');
+      if (t > TTL_MAX) return NULL;
+      p++;
+    }
+    if (t == 0) return NULL;
+  }
+  if ((*p != ';') && (*p != 0)) return NULL;
+  position = v;
+  is_group = g;
+  new_state = s;
+  ttl = t;
+  return p;
+}
+
+// takes the new values from MQTT (see statusHandler()) and sets them
+// sending n=M to the payload will change state n (numeric) to state M (alphanumeric, see POSSIBLE_STATES)
+// several pairs can be sent at once, seperated by semicolon: n1=M1;n2=M2;...
+// "gk=M" sets all states of group k to M, see applyGroups()
+// "n=M@ttl" lets state n fade to STALE_STATE unless it is set again within ttl seconds (sending it again is a keepalive),
+// setting it without a ttl (or with a full frame) ends that
+// alternatively a full frame can be sent without any "=": the first char sets state 0, the second state 1, ...
+// a malformed message changes nothing at all, see applyEntries()
+// every change will result in a status update via MQTT (see statusChanged())
+// returns false if the message was rejected
+bool applyStatus(const char* v) {
+  if (*v == 0) return false;
+
+  bool changed = false;
+  uint16_t now = millis();
+  if (strchr(v, '=') == NULL) {
+    // positional full frame, one char per state
+    if (strlen(v) > led_count) return false;
+    for (const char* p = v; *p; p++) {
+      if (stateIndex(*p) == -1) return false;
+    }
+    for (uint16_t i = 0; v[i]; i++) {
+      changed |= changeState(i, stateIndex(v[i]), now);
+      setExpiry(i, 0);
+    }
+  } else {
+    // list of n=M pairs
+    bool ok = applyEntries(v, [&](const char* p, bool apply) {
+      uint16_t position;
+      bool is_group;
+      uint8_t new_state;
+      uint16_t ttl;
+      p = parseStatusPair(p, position, is_group, new_state, ttl);
+      if ((p == NULL) || !apply) return p;
+      if (is_group) {
+        // one pass over the groups, every member changes at the same time
+        for (uint16_t j = 0; j < led_count; j++) {
+          if (group[j] == position) {
+            changed |= changeState(j, new_state, now);
+            setExpiry(j, ttl);
+          }
+        }
+      } else {
+        changed |= changeState(position, new_state, now);
+        setExpiry(position, ttl);
+      }
+      return p;
+    });
+    if (!ok) return false;
+  }
+  if (changed) statusChanged(); // status update is due once because we changed state[]
+  return true;
+}
+
+// returns the value of a hex digit or -1 if it is none
+int8_t hexValue(char c) {
+  if ((c >= '0') && (c <= '9')) return c - '0';
+  if ((c >= 'a') && (c <= 'f')) return c - 'a' + 10;
+  if ((c >= 'A') && (c <= 'F')) return c - 'A' + 10;
+  return -1;
+}
+
+// takes a new mapping set from MQTT (see mappingHandler()) and adjusts led mapping to event slots
+// sending n1;n2;n3;...(nx = numeric, no spaces, just semicolon as seperator
+// will map led1 to slot n1, led2 to n2, ... 
+// for large strips there is a compact format: "x" followed by four hex digits per led (e.g. x0000000300030004),
+// ffff (or anything else out of range) is black and any non hex digit rejects the whole message
+// If less then led_count values are sent, rest will be black, if more are send, rest is ignored, 
+// any nonnumeric fields will be black
+// the payload is parsed in place, there are no copies of it
+// returns false if the message was rejected
+bool applyMapping(const char* v) {
+  const char* p = v;
+  uint16_t n = 0;
+  uint16_t* staged = NULL;
+
+  if (*p == 'x') {
+    // compact hex format, check everything first
+    p++;
+    unsigned int length = strlen(p);
+    if (length % 4 != 0) return false;
+    for (unsigned int i = 0; i < length; i++) {
+      if (hexValue(p[i]) == -1) return false;
+    }
+    staged = stageMapping();
+    while ((n < led_count) && (*p)) {
+      uint16_t v = (hexValue(p[0]) << 12) | (hexValue(p[1]) << 8) | (hexValue(p[2]) << 4) | hexValue(p[3]);
+      staged[n++] = (v < led_count) ? v : led_count;
+      p += 4;
+    }
+  } else {
+    staged = stageMapping();
+    while (n < led_count) {
+      // read the field up to the next semicolon (or the end)
+      uint32_t v = 0;
+      bool numeric = (*p != ';') && (*p != 0);
+      bool seenDecimal = false;
+      for (; (*p != ';') && (*p != 0); p++) {
+        if (isDigit(*p)) {
+          if (!seenDecimal && (v < led_count)) v = v * 10 + (*p - '0');   // decimals are cut off
+        } else if ((*p == '.') && !seenDecimal) {
+          seenDecimal = true;
+        } else {
+          numeric = false;
+        }
+      }
+      // ohoh, no number here or number is out of scale, so led will be black
+      staged[n++] = (numeric && (v < led_count)) ? v : led_count;
+      if (*p == 0) break;
+      p++;      // skip the semicolon
+    }
+  }
+  if (n < led_count) {
+    // we left to early, so let's black out the rest of the leds
+    for (int i = n; i< led_count; i++) {
+      staged[i] = led_count;
+    }
+  }
+  mapping_changed = true;   // with the next frame, the mapping is staged until then (see commitStaged())
+  configChanged();
+  return true;
+}
+
+// parses one "k=n1,n2,n3-n4,..." entry starting at p (k the group 1..GROUPS_MAX, n the states in it, n3-n4 a range)
+// and puts the states into group k as well, if apply is set
+// returns a pointer to the char behind the entry (either ';' or the end of the string)
+// or NULL if the entry is malformed
+const char* parseGroup(const char* p, bool apply) {
+  uint32_t k = 0;
+  if (!isDigit(*p)) return NULL;
+  while (isDigit(*p)) {
+    k = k * 10 + (*p - '0');
+    if (k > GROUPS_MAX) return NULL;
+    p++;
+  }
+  if ((k == 0) || (*p != '=')) return NULL;
+  p++;
+  if (apply) {
+    for (uint16_t j = 0; j < led_count; j++) {
+      if (group[j] == k) group[j] = 0;    // the entry replaces the group
+    }
+  }
+  while ((*p != ';') && (*p != 0)) {
+    uint32_t range[2] = { 0, 0 };
+    for (int r = 0; r < 2; r++) {
+      if (!isDigit(*p)) return NULL;
+      while (isDigit(*p)) {
+        range[r] = range[r] * 10 + (*p - '0');
+        if (range[r] >= led_count) return NULL;
+        p++;
+      }
+      if ((r == 0) && (*p == '-')) {
+        p++;
+      } else {
+        if (r == 0) range[1] = range[0];
+        break;
+      }
+    }
+    if (range[1] < range[0]) return NULL;
+    if (apply) {
+      for (uint32_t j = range[0]; j <= range[1]; j++) group[j] = k;
+    }
+    if (*p == ',') {
+      p++;
+      if ((*p == ';') || (*p == 0)) return NULL;
+    } else if ((*p != ';') && (*p != 0)) {
+      return NULL;
+    }
+  }
+  return p;
+}
+
+// puts states into groups, sending k=n1,n2,n3-n4 makes states n1, n2 and n3 to n4 the members of group k
+// (a state is in one group at most), several groups can be set at once, seperated by semicolon: 1=0,1,2;2=8-15
+// "k=" empties group k, a malformed message changes nothing at all (see applyEntries())
+bool applyGroups(const char* v) {
+  if (!applyEntries(v, parseGroup)) return false;
+  configChanged();
+  return true;
+}
+
+// reads a 16 bit little endian number
+uint16_t readLE16(const uint8_t* p) {
+  return p[0] | (p[1] << 8);
+}
+
+// checks (apply = false) or applies (apply = true) a binary control message of length bytes
+// it is a sequence of records, each is the type (1 byte), the length of its data (2 bytes) and the data:
+//  - BINARY_FRAME: first state (2 bytes), then one byte per state, the index of its char in POSSIBLE_STATES
+//  - BINARY_MAPPING: first led (2 bytes), then 2 bytes per led, the state it shows (led_count or more is black)
+//  - BINARY_PALETTE: 4 bytes per color, the index of the state's char and r, g, b
+// all numbers are little endian, a full frame, mapping and palette fit into one message
+bool parseBinary(const uint8_t* m, size_t length, bool apply) {
+  bool changed = false;
+  bool mapped = false;
+  bool colored = false;
+  uint16_t now = millis();
+  size_t i = 0;
+  while (i < length) {
+    if (i + 3 > length) return false;
+    uint8_t type = m[i];
+    uint16_t l = readLE16(m + i + 1);
+    const uint8_t* d = m + i + 3;
+    i += 3 + l;
+    if (i > length) return false;
+    switch (type) {
+      case BINARY_FRAME: {
+        if (l < 2) return false;
+        uint32_t first = readLE16(d);
+        if (first + l - 2 > led_count) return false;
+        for (uint16_t k = 2; k < l; k++) {
+          if (d[k] >= NUM_STATES) return false;
+          if (apply) {
+            changed |= changeState(first + k - 2, d[k], now);
+            setExpiry(first + k - 2, 0);
+          }
+        }
+        break;
+      }
+      case BINARY_MAPPING: {
+        if ((l < 2) || (l % 2 != 0)) return false;
+        uint32_t first = readLE16(d);
+        if (first + (l - 2) / 2 > led_count) return false;
+        if (apply) {
+          uint16_t* staged = stageMapping();
+          for (uint16_t k = 2; k < l; k += 2) {
+            uint16_t v = readLE16(d + k);
+            staged[first + (k - 2) / 2] = (v < led_count) ? v : led_count;
+          }
+        }
+        mapped = true;
+        break;
+      }
+      case BINARY_PALETTE: {
+        if (l % 4 != 0) return false;
+        for (uint16_t k = 0; k < l; k += 4) {
+          if (d[k] >= NUM_STATES) return false;
+          if (apply) stagePalette()[d[k]] = rgb2hsv_approximate(CRGB(d[k + 1], d[k + 2], d[k + 3]));
+        }
+        colored = true;
+        break;
+      }
+      default:
+        return false;
+    }
+  }
+  if (apply) {
+    if (changed) statusChanged();
+    if (mapped) mapping_changed = true;
+    if (mapped || colored) configChanged();     // both are staged until the next frame, see commitStaged()
+  }
+  return true;
+}
+
+// parses one "M=ms" pair starting at p (M a single char of POSSIBLE_STATES or * for all, ms the fade time in milliseconds)
+// returns a pointer to the char behind the pair (either ';' or the end of the string)
+// or NULL if the pair is malformed, s is NUM_STATES for all states
+const char* parseFadeTimePair(const char* p, uint8_t &s, uint16_t &ms) {
+  int16_t i = (*p == '*') ? NUM_STATES : stateIndex(*p);
+  if ((i == -1) || (p[1] != '=')) return NULL;
+  p += 2;
+  if (!isDigit(*p)) return NULL;
+  uint32_t v = 0;
+  while (isDigit(*p)) {
+    v = v * 10 + (*p - '0');
+    if (v > FADE_TIME_MAX) return NULL;
+    p++;
+  }
+  if ((v < 2) || ((*p != ';') && (*p != 0))) return NULL;
+  s = i;
+  ms = v;
+  return p;
+}
+
+// sets the fade times of states, sending M=ms lets fades to state M take ms milliseconds
+// several can be set at once, seperated by semicolon, "*=ms" sets all of them: *=800;x=3000
+// a malformed message changes nothing at all, see applyEntries()
+bool applyFadeTimes(const char* v) {
+  bool ok = applyEntries(v, [](const char* p, bool apply) {
+    uint8_t s;
+    uint16_t ms;
+    p = parseFadeTimePair(p, s, ms);
+    if ((p == NULL) || !apply) return p;
+    if (s == NUM_STATES) {
+      for (unsigned int i = 0; i < NUM_STATES; i++) setFadeTime(i, ms);
+    } else {
+      setFadeTime(s, ms);
+    }
+    return p;
+  });
+  if (!ok) return false;
+  configChanged();
+  return true;
+}
+
+// parses one "M=effect" pair starting at p (M a single char of POSSIBLE_STATES or * for all, effect one of EFFECT_NAMES
+// optionally followed by ":speed", the cycles within EFFECT_PERIOD, 1..16)
+// returns a pointer to the char behind the pair (either ';' or the end of the string)
+// or NULL if the pair is malformed, s is NUM_STATES for all states
+const char* parseEffectPair(const char* p, uint8_t &s, StateEffect &effect) {
+  int16_t i = (*p == '*') ? NUM_STATES : stateIndex(*p);
+  if ((i == -1) || (p[1] != '=')) return NULL;
+  p += 2;
+  uint8_t type = EFFECT_COUNT;
+  for (uint8_t t = 0; t < EFFECT_COUNT; t++) {
+    size_t l = strlen(EFFECT_NAMES[t]);
+    if (strncmp(p, EFFECT_NAMES[t], l) == 0) {
+      type = t;
+      p += l;
+      break;
+    }
+  }
+  if (type == EFFECT_COUNT) return NULL;
+  uint32_t speed = 1;
+  if (*p == ':') {
+    p++;
+    if (!isDigit(*p)) return NULL;
+    speed = 0;
+    while (isDigit(*p)) {
+      speed = speed * 10 + (*p - '0');
+      if (speed > 16) return NULL;
+      p++;
+    }
+    if (speed == 0) return NULL;
+  }
+  if ((*p != ';') && (*p != 0)) return NULL;
+  s = i;
+  effect.type = type;
+  effect.speed = speed;
+  return p;
+}
+
+// sets the effects of states, sending M=blink lets state M blink once per EFFECT_PERIOD, M=pulse:4 pulses
+// it four times as fast and M=none ends it, several can be set at once, seperated by semicolon, "*=..." sets all of them
+// a malformed message changes nothing at all, see applyEntries()
+bool applyEffects(const char* v) {
+  bool ok = applyEntries(v, [](const char* p, bool apply) {
+    uint8_t s;
+    StateEffect effect;
+    p = parseEffectPair(p, s, effect);
+    if ((p == NULL) || !apply) return p;
+    if (s == NUM_STATES) {
+      for (unsigned int i = 0; i < NUM_STATES; i++) stateEffect[i] = effect;
+    } else {
+      stateEffect[s] = effect;
+    }
+    return p;
+  });
+  if (!ok) return false;
+  activateAllSlots();
+  configChanged();
+  return true;
+}
+
+// parses one "M=rrggbb" pair starting at p (M a single char of POSSIBLE_STATES, rrggbb the color in hex)
+// returns a pointer to the char behind the pair (either ';' or the end of the string)
+// or NULL if the pair is malformed
+const char* parsePalettePair(const char* p, uint8_t &s, CRGB &color) {
+  int16_t i = stateIndex(*p);
+  if ((i == -1) || (p[1] != '=')) return NULL;
+  p += 2;
+  uint32_t rgb = 0;
+  for (int n = 0; n < 6; n++, p++) {
+    int8_t v = hexValue(*p);
+    if (v == -1) return NULL;
+    rgb = (rgb << 4) | v;
+  }
+  if ((*p != ';') && (*p != 0)) return NULL;
+  s = i;
+  color = CRGB(rgb);
+  return p;
+}
+
+// sets the colors of states, sending M=rrggbb sets state M to the color rrggbb (hex RGB)
+// several colors can be set at once, seperated by semicolon: M1=rrggbb;M2=rrggbb;...
+// a malformed message changes nothing at all (see applyEntries()), the new colors are shown with the next frame
+bool applyPalette(const char* v) {
+  bool ok = applyEntries(v, [](const char* p, bool apply) {
+    uint8_t s;
+    CRGB color;
+    p = parsePalettePair(p, s, color);
+    if ((p != NULL) && apply) stagePalette()[s] = rgb2hsv_approximate(color);    // see commitStaged()
+    return p;
+  });
+  if (!ok) return false;
+  configChanged();
+  return true;
+}
+
+// calculate the color of state j and especially its value (in HSV mode)
+// it respects and calculates the fading from one to the next state
+// full heat is applied after the middle of the fade is crossed
+// the brightness only depends on the time since the fade started, so late or dropped frames don't slow it down
+// returns true as long as the state is fading or cooling and needs to be calculated again
+bool renderSlot(int j, uint16_t now) {
+  CHSV c;
+  uint8_t shown = state[j];     // the state whose color is shown
+  if (isFading(j)) {
+    // ok, we are fading
+    uint8_t next = stateNext[j];
+    uint16_t elapsed = now - fadeStart[j];
+    uint16_t half = stateFadeTime[next] / 2;
+    if (elapsed < half) {
+      // we are still fading out, keep going
+      c = stateColor[state[j]];
+      c.val = scale8(scale8(c.val, 255 - fadeFraction(elapsed, next)), heat[j]);
+    } else if (elapsed < 2 * half) {
+      // we have crossed the middle and are fading in, so heat to the max
+      heat[j] = 255;
+      shown = next;
+      c = stateColor[next];
+      c.val = scale8(c.val, fadeFraction(elapsed - half, next));   // already full heat
+    } else {
+      // ok, fading is done, target color reached
+      heat[j] = 255;
+      state[j] = next;
+      shown = next;
+      c = stateColor[state[j]];
+      c.val = scale8(c.val, heat[j]);
+      slotFading[j >> 3] &= ~(1 << (j & 7));
+      statusChanged(); // status update is due because we changed state[]
+    }
+  } else {
+    // no fading, so take state's color and cool applied to active heat
+    c = stateColor[state[j]];
+    c.val = scale8(c.val, heat[j]);
+  }
+  // effects are on top of fading and heat, they keep the state active (and the frames coming) for good
+  const StateEffect &e = stateEffect[shown];
+  bool animated = (e.type != EFFECT_NONE);
+  if (animated) {
+    c.val = scale8(c.val, pgm_read_byte(&effectTable.level[e.type - 1][(uint8_t) (effect_phase * e.speed)]));
+    frame_animated = true;
+  }
+  c.val = gammaCurve[c.val];
+  CRGB rgb = c;
+  if (ledsUnmapped[j] != rgb) {
+    ledsUnmapped[j] = rgb;
+    slotChanged[j >> 3] |= 1 << (j & 7);
+  }
+  return isFading(j) || (heat[j] > brightness_cold) || animated;
+}
+
+// calculate the colors of all active states, idle ones keep their color
+// only leds mapped to a state which changed are copied
+// frames are only calculated while states are fading, cooling states are drawn after each cooling step
+// once there is nothing left to do, both stop until the next change (see wakeFading())
+// now is the millis() of the frame, the same for all states so they fade (and blink) in step
+// nothing in here reads the clock, so a frame only depends on the states and the time it is calculated for
+// states with an effect need frames for good, but a frame is only shown if an effect changed an output byte
+void doFading(uint32_t now) {
+  bool changed = false;
+  bool active = false;
+  bool fading = false;
+  commitStaged();   // palette and mapping only change between two frames
+  effect_phase = ((now % EFFECT_PERIOD) << 8) / EFFECT_PERIOD;
+  frame_animated = false;
+  for (int b=0; b<slot_mask_bytes; b++) {
+    if (slotActive[b] == 0) continue;
+    for (int j=b*8; (j<b*8+8) && (j<led_count); j++) {
+      if (slotActive[b] & (1 << (j & 7))) {
+        if (!renderSlot(j, now)) {
+          slotActive[b] &= ~(1 << (j & 7));   // nothing more to do for this one
+        }
+      }
+    }
+    fading |= (slotFading[b] != 0);
+    changed |= (slotChanged[b] != 0);
+    active |= (slotActive[b] != 0);
+  }
+  if (!fading && !frame_animated) tasks[TASK_FADING].pending = false;
+  if (!active) tasks[TASK_COOLING].pending = false;
+  if (!changed && !mapping_changed) return;
+
+  // copy to the mapped leds, the frame only needs to be shown if any of them changed
+  // (fading as well as cooling ends up here)
+  for (int j=0; j<led_count; j++) {
+    uint16_t m = mapping[j];
+    if (mapping_changed || (slotChanged[m >> 3] & (1 << (m & 7)))) setLed(j, ledsUnmapped[m]);
+  }
+  mapping_changed = false;
+  memset(slotChanged, 0, slot_mask_bytes);
+}
+
+// cool down brightness after changes
+// states only cool down while they are active (see renderSlot()), they are drawn with the next frame
+void doCooling() {
+  bool cooled = false;
+  for (int b=0; b<slot_mask_bytes; b++) {
+    if (slotActive[b] == 0) continue;
+    for (int j=b*8; (j<b*8+8) && (j<led_count); j++) {
+      if (heat[j]> brightness_cold) {
+        // simple function to reduce heat to the value of "cold" (brightness calculates linear but is sensed logarithmically)
+        heat[j]--;
+        cooled = true;
+      }
+    }
+  }
+  if (cooled) wakeTask(TASK_FADING, 0);
+}
+
+// runs all tasks which are due and returns the milliseconds until the next one is
+// periodic tasks keep their pace, but if one is late by more than its interval
+// (e.g. because of a long Homie callback) the missed runs are skipped instead of caught up
+uint32_t runTasks() {
+  uint32_t wait = IDLE_SLEEP_MAX;
+  for (uint8_t id = 0; id < TASK_COUNT; id++) {
+    Task &t = tasks[id];
+    if (!t.pending) continue;
+    uint32_t now = millis();
+    if ((int32_t) (now - t.due) >= 0) {
+      if (t.interval > 0) {
+        t.due += t.interval;
+        if ((int32_t) (now - t.due) >= 0) t.due = now + t.interval;
+      } else {
+        t.pending = false;
+      }
+      runTask(id);
+    }
+    if (t.pending) {
+      int32_t left = t.due - millis();
+      if (left <= 0) {
+        wait = 0;
+      } else if ((uint32_t) left < wait) {
+        wait = left;
+      }
+    }
+  }
+  return wait;
+}
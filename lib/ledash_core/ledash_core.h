@@ -0,0 +1,187 @@
+/*
+ * IoT Dashboard - core
+ * Author: Lars Friedrichs
+ * License: GPL2
+ *
+ * Everything that turns control and config messages into frames: the states and their fades, cooling,
+ * effects, time to live, groups, the staged palette and mapping, the message parsers and the task table.
+ * Nothing in here touches the hardware, MQTT or the flash, so the same code is built for the ESP8266
+ * (see src/main.cpp) and for the host (env:native, see test/), where ledash_host.h stands in for
+ * Arduino and FastLED.
+ * The application implements the functions at the end of this file, they are the only way out of the core.
+ */
+
+#ifndef LEDASH_CORE_H
+#define LEDASH_CORE_H
+
+#ifdef ARDUINO
+#include <Arduino.h>
+#include "FastLED.h"
+#else
+#include "ledash_host.h"
+#endif
+
+// FastLED draws leds[], the NeoPixelBus outputs (LED_OUTPUT_DMA, LED_OUTPUT_UART1) have a buffer of their own
+#if !defined(LED_OUTPUT_DMA) && !defined(LED_OUTPUT_UART1)
+#define LED_BUFFER
+#endif
+
+#define GAMMA 2.2                  // the eye sees brightness about like this, fades and heat are spread evenly for it
+#ifndef FADE_TIME
+#define FADE_TIME 1400             // milliseconds of a fade to a state (half out, half in), can be set per state
+#endif
+#define FADE_TIME_MAX 60000        // fades are timed with 16 bit millis(), so they have to be shorter than 65.5 seconds
+#define EFFECT_PERIOD 4000         // milliseconds of the shared effect phase, effects repeat 1..16 times within it
+#define EFFECT_PULSE_LOW 48        // lowest brightness of a pulse (0..255)
+static_assert((FADE_TIME >= 2) && (FADE_TIME <= FADE_TIME_MAX), "FADE_TIME has to be within 2..FADE_TIME_MAX");
+#define BRIGHTNESS_COLD 128       // relative brightness to global brightness value (128 = half as bright)
+#define STALE_STATE '?'           // state a slot fades to once its time to live is over ("n=M@ttl", see applyStatus())
+#define TTL_MAX 32767             // longest time to live in seconds, deadlines are 16 bit seconds compared wrap-safe
+#define NO_EXPIRY 0xffff          // expiryIndex[] of slots without a time to live
+#define GROUPS_MAX 255            // states can be put into groups 1..GROUPS_MAX, 0 = no group
+#define BINARY_FRAME 0x01         // record types of binary control messages, see parseBinary()
+#define BINARY_MAPPING 0x02
+#define BINARY_PALETTE 0x03
+#define IDLE_SLEEP_MAX 10         // longest milliseconds to sleep while no task is due, so Homie.loop() is still called often
+
+constexpr char POSSIBLE_STATES[] PROGMEM = "0123456789abcdefghijklmnopqrstuvwxyz-_:.?!$%/<>ABCDEFGHIJKLMNOPQRSTUVWXYZ ";
+#define NUM_STATES (sizeof(POSSIBLE_STATES) - 1)
+
+// index of each char in POSSIBLE_STATES (0xff for chars that are no state), generated at compile time
+struct StateLookup {
+  uint8_t index[128];
+  constexpr StateLookup() : index() {
+    for (int c = 0; c < 128; c++) index[c] = 0xff;
+    for (unsigned int i = 0; i < NUM_STATES; i++) index[(uint8_t) POSSIBLE_STATES[i]] = i;
+  }
+};
+static_assert(StateLookup().index[(uint8_t) STALE_STATE] != 0xff, "STALE_STATE has to be one of POSSIBLE_STATES");
+
+// effects a state can have, see StateEffect
+enum EffectType {
+  EFFECT_NONE,
+  EFFECT_BLINK,       // on for the first half of each cycle, off for the second
+  EFFECT_PULSE,       // smoothly down to EFFECT_PULSE_LOW and back up
+  EFFECT_COUNT
+};
+const char* const EFFECT_NAMES[EFFECT_COUNT] = { "none", "blink", "pulse" };
+
+// the effect of a state, speed is the number of cycles within EFFECT_PERIOD (1..16)
+struct StateEffect {
+  uint8_t type;
+  uint8_t speed;
+};
+
+// everything done in loop() besides Homie is a task, which runs when it is due (see runTasks())
+enum TaskId {
+  TASK_SELFTEST,    // next step of the self-test, while it runs
+  TASK_FADING,      // next frame, while states are fading or cooling
+  TASK_COOLING,     // next cooling step, while states are cooling
+  TASK_SENSOR,      // next light sensor reading, the interval adapts in getLightSensor()
+  TASK_DITHER,      // refresh for temporal dithering, if dither_refresh is set
+  TASK_STATUS,      // pending status update
+  TASK_CONFIG,      // pending write of the configuration
+  TASK_STATES,      // pending write of the states
+  TASK_STATS,       // next update of the stats node, if stats_interval is set
+  TASK_EXPIRY,      // the next slot's time to live is over, see scheduleExpiry()
+  TASK_COUNT
+};
+
+struct Task {
+  uint32_t interval;    // milliseconds between two runs, 0 = runs once each time it is scheduled
+  uint32_t due;         // millis() of the next run
+  bool pending;         // false while there is nothing to do
+};
+
+// how tight memory is, the worse it is the less is done, see checkMemory()
+enum MemoryLevel : uint8_t {
+  MEMORY_OK,        // nothing to worry about
+  MEMORY_LOW,       // fewer frames and status updates, binaryBuffer is not allocated
+  MEMORY_CRITICAL,  // even fewer of them, no flash writes, no stats, large messages are rejected and binaryBuffer is freed
+};
+
+// all of these have led_count entries and are allocated at boot, see allocateLeds()
+extern uint8_t* state;                          // stores the actual state
+extern uint8_t* stateNext;                      // stores the next state after fading out
+extern uint8_t* statePublished;                 // stores the state last sent via MQTT (for delta updates)
+extern uint16_t* fadeStart;                     // stores the (16 bit) millis() the fade started, see renderSlot()
+extern uint16_t* expiryHeap;                    // slots with a time to live, a binary min-heap ordered by expiryDue[]
+extern uint16_t* expiryIndex;                   // stores the position of each slot in expiryHeap (or NO_EXPIRY)
+extern uint16_t* expiryDue;                     // stores the second (see expirySeconds()) each slot expires at
+extern CRGB* ledsUnmapped;                      // stores the state's colors (plus a black one behind them)
+extern CRGB* leds;                              // stores the led's colors (FastLED only, see LED_BUFFER)
+extern char* statusString;                      // buffer for status updates (plus the terminating zero and room for the sequence number)
+extern uint16_t* mapping;                       // this way we can map all inputs at different places later, led_count = black
+extern uint8_t* heat;                           // fresh changes should be brighter
+extern uint8_t* group;                          // group of each state (0 = none), a status pair for the group sets all of them
+extern uint8_t* slotActive;                     // bitmask of states that are fading, cooling or need to be redrawn
+extern uint8_t* slotFading;                     // bitmask of states that are fading
+extern uint8_t* slotChanged;                    // bitmask of states whose color changed in the current frame
+extern uint16_t led_count;                      // set from the led_count setting at boot
+extern uint16_t slot_mask_bytes;                // size of the bitmasks above, one bit per state (plus the black one)
+
+extern uint8_t brightness_cold;                 // can be changed via MQTT, see the config node in setup()
+extern uint8_t gammaCurve[256];                 // led value for each perceived value at this brightness, see buildGammaCurve()
+extern uint16_t stateFadeTime[NUM_STATES];      // milliseconds of a fade to each state, see setFadeTime()
+extern uint32_t stateFadeRate[NUM_STATES];      // 255 / half the fade time, 16.16 fixed point, see fadeFraction()
+extern StateEffect stateEffect[NUM_STATES];     // effect of each state, see applyEffects()
+extern uint8_t effect_phase;                    // phase (0..255 within EFFECT_PERIOD) of the frame being calculated
+extern bool frame_animated;                     // a state with an effect was drawn in this frame, so more frames are due
+extern CHSV stateColor[NUM_STATES];             // stores the color to each state, see DEFAULT_PALETTE and applyPalette()
+extern CHSV stateColorStaged[NUM_STATES];       // palette changes wait here for the next frame, see commitStaged()
+extern bool palette_staged;                     // stateColorStaged[] has changes for the next frame
+extern bool mapping_changed;                    // all mapped leds need to be copied in the next frame
+extern uint16_t* mappingStaged;                 // mapping changes wait here for the next frame, allocated with the first one
+extern bool mapping_staged;                     // mappingStaged has changes for the next frame
+extern uint8_t memory_level;                    // MEMORY_OK, MEMORY_LOW or MEMORY_CRITICAL, see checkMemory()
+extern uint16_t expiry_count;                   // slots in expiryHeap
+extern uint16_t expiry_seconds;                 // seconds since boot (16 bit), see expirySeconds()
+extern uint32_t expiry_seconds_last;            // millis() expiry_seconds was counted up to
+extern Task tasks[TASK_COUNT];                  // the intervals are set by the application
+
+bool allocateLeds(uint16_t count);
+char stateChar(uint8_t s);
+int16_t stateIndex(char c);
+void scheduleTask(uint8_t id, uint32_t delay_ms);
+void wakeTask(uint8_t id, uint32_t delay_ms);
+uint32_t remaining(uint32_t last, uint32_t interval);
+uint32_t runTasks();
+void setFadeTime(uint8_t s, uint16_t ms);
+uint8_t fadeFraction(uint16_t elapsed, uint8_t s);
+uint16_t fadeElapsed(uint8_t fraction, uint8_t s);
+void wakeFading();
+void activateSlot(uint16_t position);
+bool isFading(uint16_t j);
+void activateAllSlots();
+CHSV* stagePalette();
+uint16_t* stageMapping();
+void commitStaged();
+void buildGammaCurve(uint8_t b);
+bool changeState(uint16_t position, uint8_t new_state, uint16_t now);
+uint16_t expirySeconds();
+void setExpiry(uint16_t slot, uint16_t ttl);
+void doExpiry();
+int8_t hexValue(char c);
+const char* parseStatusPair(const char* p, uint16_t &position, bool &is_group, uint8_t &new_state, uint16_t &ttl);
+bool applyStatus(const char* v);
+bool applyMapping(const char* v);
+const char* parseGroup(const char* p, bool apply);
+bool applyGroups(const char* v);
+bool parseBinary(const uint8_t* m, size_t length, bool apply);
+const char* parseFadeTimePair(const char* p, uint8_t &s, uint16_t &ms);
+bool applyFadeTimes(const char* v);
+const char* parseEffectPair(const char* p, uint8_t &s, StateEffect &effect);
+bool applyEffects(const char* v);
+const char* parsePalettePair(const char* p, uint8_t &s, CRGB &color);
+bool applyPalette(const char* v);
+bool renderSlot(int j, uint16_t now);
+void doFading(uint32_t now);
+void doCooling();
+
+// implemented by the application
+void runTask(uint8_t id);                       // runs task id, it is due (see runTasks())
+void statusChanged();                           // state[] changed, a status update is due
+void configChanged();                           // the configuration changed, it has to be written to flash
+void setLed(uint16_t j, const CRGB &c);         // sets led j to color c, it is shown with the next frame
+
+#endif
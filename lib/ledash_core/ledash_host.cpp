@@ -0,0 +1,63 @@
+// the host stand-ins of ledash_host.h, on the ESP8266 FastLED has all of this
+
+#ifndef ARDUINO
+
+#include "ledash_host.h"
+
+// six sectors of the hue circle, desaturated and dimmed like FastLED's hsv2rgb_rainbow
+// the value is squared (its dimming curve, see buildGammaCurve()), but a lit color stays lit
+CRGB::CRGB(const CHSV &c) {
+  uint8_t sector = ((uint16_t) c.h * 6) >> 8;
+  uint8_t rise = ((uint16_t) c.h * 6) & 0xff;
+  uint8_t fall = 255 - rise;
+  uint8_t rgb[3];
+  switch (sector) {
+    case 0:  rgb[0] = 255;  rgb[1] = rise; rgb[2] = 0;    break;
+    case 1:  rgb[0] = fall; rgb[1] = 255;  rgb[2] = 0;    break;
+    case 2:  rgb[0] = 0;    rgb[1] = 255;  rgb[2] = rise; break;
+    case 3:  rgb[0] = 0;    rgb[1] = fall; rgb[2] = 255;  break;
+    case 4:  rgb[0] = rise; rgb[1] = 0;    rgb[2] = 255;  break;
+    default: rgb[0] = 255;  rgb[1] = 0;    rgb[2] = fall; break;
+  }
+  uint8_t v = c.v;
+  if ((v != 255) && (v != 0)) {
+    v = scale8(v, v);
+    if (v == 0) v = 1;
+  }
+  uint8_t white = 255 - c.s;
+  for (int i = 0; i < 3; i++) {
+    uint8_t x = white + scale8(rgb[i], c.s);
+    rgb[i] = (c.v == 255) ? x : scale8(x, v + 1);
+  }
+  r = rgb[0];
+  g = rgb[1];
+  b = rgb[2];
+}
+
+// hue, saturation and value of rgb, about the color CRGB(CHSV) turns it back into
+CHSV rgb2hsv_approximate(const CRGB &rgb) {
+  uint8_t hi = rgb.r;
+  uint8_t lo = rgb.r;
+  if (rgb.g > hi) hi = rgb.g;
+  if (rgb.b > hi) hi = rgb.b;
+  if (rgb.g < lo) lo = rgb.g;
+  if (rgb.b < lo) lo = rgb.b;
+  if (hi == 0) return CHSV(0, 0, 0);
+  uint8_t delta = hi - lo;
+  uint8_t sat = ((uint16_t) delta * 255) / hi;
+  int16_t hue = 0;
+  if (delta > 0) {
+    int32_t h;
+    if (hi == rgb.r) {
+      h = (int32_t) 43 * (rgb.g - rgb.b) / delta;
+    } else if (hi == rgb.g) {
+      h = 85 + (int32_t) 43 * (rgb.b - rgb.r) / delta;
+    } else {
+      h = 171 + (int32_t) 43 * (rgb.r - rgb.g) / delta;
+    }
+    hue = (h + 256) & 0xff;
+  }
+  return CHSV(hue, sat, hi);
+}
+
+#endif
@@ -0,0 +1,81 @@
+/*
+ * IoT Dashboard - host stand-ins
+ * Author: Lars Friedrichs
+ * License: GPL2
+ *
+ * The little the core needs from Arduino and FastLED, so it builds on the host (env:native) as well.
+ * Only what the core uses is here, CRGB(CHSV) follows FastLED's rainbow conversion closely enough for the
+ * tests, but the colors are not bit for bit the ones of the dashboard.
+ */
+
+#ifndef LEDASH_HOST_H
+#define LEDASH_HOST_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#define PROGMEM
+#define pgm_read_byte(addr) (*(const uint8_t*) (addr))
+
+uint32_t millis();                              // implemented by the tests, they run on a clock of their own
+
+inline bool isDigit(char c) {
+  return (c >= '0') && (c <= '9');
+}
+
+// a * (b + 1) / 256, like FastLED's (so scale8(255, 255) is 255)
+inline uint8_t scale8(uint8_t a, uint8_t b) {
+  return ((uint16_t) a * (1 + b)) >> 8;
+}
+
+// the integer square root of x, like FastLED's
+inline uint8_t sqrt16(uint16_t x) {
+  uint16_t r = 0;
+  while ((r < 255) && ((r + 1) * (r + 1) <= x)) r++;
+  return r;
+}
+
+struct CHSV {
+  union {
+    struct {
+      uint8_t hue;
+      uint8_t sat;
+      uint8_t val;
+    };
+    struct {
+      uint8_t h;
+      uint8_t s;
+      uint8_t v;
+    };
+  };
+  CHSV() : h(0), s(0), v(0) {}
+  CHSV(uint8_t hue, uint8_t sat, uint8_t val) : h(hue), s(sat), v(val) {}
+};
+
+struct CRGB {
+  uint8_t r;
+  uint8_t g;
+  uint8_t b;
+  // the colors DEFAULT_PALETTE uses
+  enum HTMLColorCode {
+    Black = 0x000000,
+    Red = 0xFF0000,
+    Yellow = 0xFFFF00,
+    Green = 0x008000,
+    Blue = 0x0000FF,
+    Violet = 0xEE82EE
+  };
+  CRGB() : r(0), g(0), b(0) {}
+  CRGB(uint8_t ir, uint8_t ig, uint8_t ib) : r(ir), g(ig), b(ib) {}
+  CRGB(uint32_t rgb) : r(rgb >> 16), g(rgb >> 8), b(rgb) {}
+  CRGB(const CHSV &c);
+  bool operator==(const CRGB &o) const { return (r == o.r) && (g == o.g) && (b == o.b); }
+  bool operator!=(const CRGB &o) const { return !(*this == o); }
+};
+
+CHSV rgb2hsv_approximate(const CRGB &rgb);
+
+#endif
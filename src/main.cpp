@@ -10,322 +10,1337 @@
  * One configured to WiFi and MQTT (Homie configuration!) send control messages to the board
  * to the configured topic /homepath/deviceid/control/status/set.
  * Use "n=M" text format to set state number n to state M (alphanumerical).
+ * Several states can be set with one message, seperated by semicolon: "3=a;7=2;12=x".
+ * "n=M@ttl" lets state n fade to STALE_STATE if it is not set again within ttl seconds.
+ * "gk=M" sets all states of group k (see control/groups) at once.
+ * A message without any "=" is taken as full frame, one char per state starting at state 0: "0a2x".
  * The associated LED smoothly changes its color to the one of the new state. Done!
  * 
  * Build instructions: connect data pin of WS2812 to LED_PIN and TEMT6000 (3.3v) to pin LIGHT_SENSOR
- * Configure the predefined states colors in setup()
+ * Configure the predefined states colors in DEFAULT_PALETTE (or via MQTT)
  * Set overall brightness and heat/cool-down values so newly set values are brighter.
- * Map states to LEDs (code only so far)
- * 
- * unimplemented at the moment:
- *  - change brightness/cool-down/cool-down-time via MQTT
- *  - change mapping of LEDs to states via MQTT
- *  - store configuration in filesystem
+ * Map states to LEDs via MQTT (control/mapping)
  */
 
 #include <Arduino.h>
 #include "Homie.h"
 #include "FastLED.h"
-#include "RunningAverage.h"
+#include "ledash_core.h"   // states, fades and the message parsers, see lib/ledash_core
+#if defined(LED_OUTPUT_DMA) || defined(LED_OUTPUT_UART1)
+#include <NeoPixelBus.h>
+#endif
+#include <FS.h>
 
+// the hardware settings can be overridden by the build env (-D ...), so one source builds for every unit
+// see the envs in platformio.ini
 #define LIGHT_SENSOR A0
+#ifndef LED_PIN
 #define LED_PIN     D2
+#endif
+// long chains can be split over more data pins (FastLED only), LED_PIN drives the first segment of the leds,
+// LED_PIN_2 the next one and so on, see the led_segments setting
+// only segments with changed leds are sent, so a change takes the time of its segment instead of the whole chain
+#if defined(LED_PIN_4)
+#define LED_SEGMENTS 4
+#elif defined(LED_PIN_3)
+#define LED_SEGMENTS 3
+#elif defined(LED_PIN_2)
+#define LED_SEGMENTS 2
+#else
+#define LED_SEGMENTS 1
+#endif
+// by default FastLED puts the leds out, with interrupts disabled while doing so
+// build with LED_OUTPUT_DMA (I2S DMA, data on RX/GPIO3) or LED_OUTPUT_UART1 (UART1, data on D4/GPIO2)
+// to send the frames in the background with NeoPixelBus instead, LED_PIN is not used then
+#if defined(LED_OUTPUT_DMA)
+#define LED_OUTPUT_METHOD NeoEsp8266DmaWs2812xMethod
+#elif defined(LED_OUTPUT_UART1)
+#define LED_OUTPUT_METHOD NeoEsp8266AsyncUart1Ws2812xMethod
+#endif
+#if defined(LED_OUTPUT_METHOD) && (LED_SEGMENTS > 1)
+#error "NeoPixelBus output has a fixed pin, LED_PIN_2.. only work with FastLED"
+#endif
+#ifndef COLOR_ORDER
 #define COLOR_ORDER GRB
+#endif
+#ifndef LED_OUTPUT_FEATURE
+#define LED_OUTPUT_FEATURE NeoGrbFeature   // color order for NeoPixelBus, has to match COLOR_ORDER
+#endif
+#ifndef CHIPSET
 #define CHIPSET     WS2812B
-#define NUM_LEDS_MAX      20   // this needs to be lower than 254 because of byte values used... 
-#define FRAMES_PER_SECOND 50
-#define FRAMES_PER_FADE ((FRAMES_PER_SECOND * 1.4) / 2)
-#define NO_FADE (FRAMES_PER_FADE + 2)
+#endif
+#ifndef NUM_LEDS_DEFAULT
+#define NUM_LEDS_DEFAULT  20   // number of leds (and states) if nothing else is configured
+#endif
+#ifndef NUM_LEDS_MAX
+#define NUM_LEDS_MAX     400   // upper limit for the led_count setting, memory is allocated at boot (see allocateLeds())
+                               // there are about 40 KB of free heap before WiFi, MQTT and Homie take their share
+#endif
+static_assert((NUM_LEDS_DEFAULT > 0) && (NUM_LEDS_DEFAULT <= NUM_LEDS_MAX), "NUM_LEDS_DEFAULT has to be within 1..NUM_LEDS_MAX");
+static_assert(NUM_LEDS_MAX < 0xffff, "mapping uses 16 bit entries with ffff for black");
+#ifndef FRAMES_PER_SECOND
+#define FRAMES_PER_SECOND 50      // frames per second while fading, only the smoothness depends on it (not the fade time)
+#endif
+static_assert((FRAMES_PER_SECOND > 0) && (FRAMES_PER_SECOND <= 200), "FRAMES_PER_SECOND has to be within 1..200");
+#define DITHER_REFRESH    0        // refreshes per second for temporal dithering while nothing changes, 0 = only show changed frames
 
 #define BRIGHTNESS_HIGH  255      // preset overall brightness (aka max. brightness)
 #define BRIGHTNESS_LOW  12        // preset overall brightness for lowest brightness (aka max. brightness)
-#define BRIGHTNESS_COLD 128       // relative brightness to global brightness value (128 = half as bright)
 #define COOL_DOWN_TIME 40         // seconds after change "cold" brightness is reached
 #define SENSOR_CURVE 0.20         // exponent for relative (0..1) light sensor readings 
+#define SENSOR_CURVE_STEPS 64     // the curve is calculated for this many steps of readings, in between it is interpolated
+#define SENSOR_AVERAGE_SHIFT 5    // each reading is weighted 1/2^n in the moving average (1/32 is about the last 50 readings)
+#define SENSOR_INTERVAL_FAST 100  // milliseconds between light sensor readings while the light changes
+#define SENSOR_INTERVAL_SLOW 3000 // milliseconds between readings once the light is stable (same as fast = always fast)
+#define SENSOR_STABLE_DELTA 3     // readings (after the curve) differing no more than this from the average are stable
+#define BRIGHTNESS_HYSTERESIS 2   // the overall brightness is only changed by at least this much (or to low/high)
+#define STATUS_INTERVAL 250       // minimum milliseconds between two status updates, changes in between are coalesced
+#define STATUS_DELTA false        // send only the changed states as "n=M;..." to status-delta instead of the full status
+#define CONFIG_SAVE_DELAY 5000    // milliseconds without further changes before the configuration is written to flash
+#define FLASH_WRITE_CHUNK 256     // bytes written to flash per loop, files are written in the background (see writeStep())
+#define CONFIG_FILE "/ledash.cfg"
+#define CONFIG_FILE_TMP "/ledash.tmp"
+#define CONFIG_MAGIC 0x4853444c   // "LDSH"
+#define CONFIG_VERSION 6
+#define STATES_SAVE_INTERVAL 60000  // minimum milliseconds between two writes of the states to flash
+#define STATES_FILE "/ledash.sta"
+#define STATES_FILE_TMP "/ledash.stt"
+#define STATES_MAGIC 0x5453444c   // "LDST"
+#define FAST_BOOT false           // skip the led self-test at boot (can be changed with the fast_boot setting)
+#define SELFTEST_STEP 50          // milliseconds per led of the self-test
+#define STATS_INTERVAL 0          // seconds between two updates of the stats node, 0 = no stats are published
+#define IDLE_LIGHT_SLEEP false    // let WiFi go to light sleep while idle, saves power but adds some latency
+#define HEAP_LOW 8192             // free heap (bytes) below which memory is low, see checkMemory()
+#define HEAP_CRITICAL 4096        // free heap below which memory is critical
+#define BLOCK_LOW 4096            // largest free block below which memory is low (the heap is fragmented)
+#define BLOCK_CRITICAL 2048       // largest free block below which memory is critical
+#define MEMORY_HYSTERESIS 1024    // memory is fine again only once it is this much above the limits
+#define BLOCK_CHECK_INTERVAL 250  // milliseconds between two checks of the largest free block, it walks the whole heap
+#define MEMORY_STATUS_INTERVAL 2000 // minimum milliseconds between status updates while memory is low (4 times this if critical)
+#define MEMORY_PAYLOAD_MAX 256    // longest text message accepted while memory is critical
+
+// colors of the states as long as nothing else is configured (all the others are black)
+const uint32_t DEFAULT_PALETTE[] PROGMEM = {
+  CRGB::Black, CRGB::Black, CRGB::Red, CRGB::Yellow, CRGB::Green, CRGB::Blue, CRGB::Violet
+};
 
-const String POSSIBLE_STATES = "0123456789abcdefghijklmnopqrstuvwxyz-_:.?!$%/<>ABCDEFGHIJKLMNOPQRSTUVWXYZ ";
+// these can be changed via MQTT, see the config node in setup()
+uint8_t brightness_low  = BRIGHTNESS_LOW;
+uint8_t brightness_high = BRIGHTNESS_HIGH;
+uint8_t cool_down_time = COOL_DOWN_TIME;
+float sensor_curve_calibration = SENSOR_CURVE;
+uint16_t status_interval = STATUS_INTERVAL;
+bool status_delta = STATUS_DELTA;
+uint8_t dither_refresh = DITHER_REFRESH;
+uint8_t brightness = BRIGHTNESS_HIGH;           // overall brightness from the light sensor, see updateBrightness()
+uint8_t frames_per_second = FRAMES_PER_SECOND;
+bool frame_dirty = true;                        // leds[] or brightness changed since the last show()
+uint8_t segment_dirty = 0;                      // bitmask of segments whose leds changed since the last show()
+uint16_t segmentStart[LED_SEGMENTS + 1];        // first led of each segment (and led_count), see setupSegments()
+bool status_dirty = false;                      // state[] changed since the last status update
+uint32_t status_last_sent = 0;                  // millis() of the last status update
+uint32_t status_seq = 0;                        // status and binary messages received since boot, see sendSnapshot()
+bool config_dirty = false;                      // configuration changed since it was last written to flash
+uint32_t config_last_changed = 0;               // millis() of the last configuration change
+uint32_t config_saved_checksum = 0;             // checksum of the configuration in flash
+bool states_dirty = false;                      // state[] changed since it was last written to flash
+uint32_t states_last_saved = 0;                 // millis() of the last write of the states
+int32_t selftest_position = -1;                 // led lit by the self-test, it runs while this is below led_count + 1
 
-uint8_t state[NUM_LEDS_MAX];                    // stores the actual state
-uint8_t stateNext[NUM_LEDS_MAX];                // stores the next state after fading out
-int8_t stateFader[NUM_LEDS_MAX];                // stores the value, how far fading has progressed
-CRGB ledsUnmapped[NUM_LEDS_MAX+1];                      // stores the led's colors
-CRGB leds[NUM_LEDS_MAX+1];                      // stores the led's colors
-uint16_t led_count = 20;              // this should be customizable later
-uint8_t brightness_low  = BRIGHTNESS_LOW;       // this should be customizable later
-uint8_t brightness_high = BRIGHTNESS_HIGH;      // this should be customizable later
-uint8_t brightness_cold = BRIGHTNESS_COLD;      // this should be customizable later
-uint8_t cool_down_time = COOL_DOWN_TIME;        // this should be customizable later
-float sensor_curve_calibration = SENSOR_CURVE;  // this should be customizable later
-CHSV stateColor[256];                           // stores the color to each state - we are not using all the states, I know...
+uint32_t max_free_block = 0;           // largest free block of the heap at the last check (0 = none yet), see checkMemory()
+uint32_t block_checked = 0;            // millis() of that check
+uint8_t* binaryBuffer = NULL;          // binary control messages are collected here, allocated with the first one
+size_t binary_capacity = 0;            // size of binaryBuffer, enough for a full frame, mapping and palette
+char binaryTopic[128];                 // MQTT topic of binary control messages, see onMqttMessage()
 
-uint8_t mapping[NUM_LEDS_MAX+1];  // this way we can map all inputs at different places later
-uint8_t heat[NUM_LEDS_MAX];       // fresh changes should be brighter
+#ifdef LED_OUTPUT_METHOD
+NeoPixelBus<LED_OUTPUT_FEATURE, LED_OUTPUT_METHOD>* strip;    // double buffered, so Show() returns right away
+#endif
 
 HomieNode controlNode("control","Control LEDs","controller");  // this is to control the dashboard
 HomieNode configNode("config","Configuration","config");
+HomieNode statsNode("stats","Statistics","stats");            // performance counters, see sendStats()
+
+HomieSetting<long> ledCountSetting("led_count", "number of leds (and states) of the dashboard");
+HomieSetting<bool> fastBootSetting("fast_boot", "skip the led self-test at boot");
+HomieSetting<const char*> ledSegmentsSetting("led_segments", "leds on each data pin but the last, seperated by semicolon (default is an even split)");
+
+uint8_t sensorCurve[SENSOR_CURVE_STEPS + 1];     // 255 * (reading / 1024) ^ sensor_curve_calibration, see buildSensorCurve()
+uint16_t sensor_average = 255 << 8;              // moving average of the corrected readings, 8.8 fixed point
 
-RunningAverage avg(50);
+// the memory levels as published to stats/memory, see checkMemory()
+const char* const MEMORY_NAMES[] = { "ok", "low", "critical" };
+
+// the schedule, intervals are in milliseconds (see TaskId in ledash_core.h)
+Task tasks[TASK_COUNT] = {
+  { SELFTEST_STEP, 0, false },
+  { 1000 / FRAMES_PER_SECOND, 0, false },                          // see updateFrameInterval()
+  { (COOL_DOWN_TIME * 1000) / (255 - BRIGHTNESS_COLD), 0, false },   // see updateCoolingInterval()
+  { SENSOR_INTERVAL_FAST, 0, true },
+  { 0, 0, false },                                                   // see updateDitherInterval()
+  { 0, 0, false },
+  { 0, 0, false },
+  { 0, 0, false },
+  { 0, 0, false },                                                   // see updateStatsInterval()
+  { 0, 0, false }
+};
+
+// time spent in one part of the code, measured in cpu cycles (see addTiming())
+struct Timing {
+  uint32_t count;
+  uint32_t max;
+  uint64_t total;       // 32 bit would overflow after less than a minute at 80 MHz
+};
+
+// performance counters for the stats node, they are reset each time they are published
+struct Stats {
+  uint32_t since;               // millis() of the last reset
+  uint32_t loops;               // calls of loop()
+  uint32_t frames;              // frames calculated while fading, each following another one
+  uint32_t frame_time;          // milliseconds between these frames, for the actual frame rate
+  Timing fading;                // doFading()
+  Timing show;                  // sending a frame to the leds
+  Timing homie;                 // Homie.loop() (the MQTT handlers are not in there, see below)
+  Timing handlers;              // statusHandler(), mappingHandler() and binary messages, they run from the network
+                                // stack's callbacks whenever loop() yields (mostly in delay()), not in Homie.loop()
+  uint32_t status_accepted;
+  uint32_t status_rejected;
+  uint32_t mapping_accepted;
+  uint32_t mapping_rejected;
+  uint32_t binary_accepted;
+  uint32_t binary_rejected;
+};
+Stats stats;
+uint32_t min_free_heap = 0;                      // lowest free heap seen by checkMemory() since boot (0 = none yet)
+uint32_t memory_low_count = 0;                   // times memory got low since boot...
+uint32_t memory_critical_count = 0;              // ...or critical, these three are not reset with stats
+uint32_t stats_frame_last = 0;                   // millis() of the last frame while fading, 0 = not fading
+uint8_t stats_interval = STATS_INTERVAL;         // can be changed via MQTT
+
+// splits the leds into the segments of the data pins, spec is "n1;n2;..." with the leds of each pin
+// but the last one, which gets the rest, returns false (and splits them evenly) if spec doesn't fit
+bool setupSegments(const char* spec) {
+  const char* p = spec;
+  segmentStart[0] = 0;
+  segmentStart[LED_SEGMENTS] = led_count;
+  bool ok = true;
+  for (uint8_t s = 1; ok && (s < LED_SEGMENTS); s++) {
+    uint32_t v = segmentStart[s - 1];
+    if (!isDigit(*p)) ok = false;
+    for (uint32_t n = 0; ok && isDigit(*p); p++) {
+      n = n * 10 + (*p - '0');
+      if (v + n > led_count) ok = false;
+      segmentStart[s] = v + n;
+    }
+    if (*p == ';') p++;
+  }
+  if (!ok) {
+    for (uint8_t s = 1; s < LED_SEGMENTS; s++) segmentStart[s] = ((uint32_t) led_count * s) / LED_SEGMENTS;
+  }
+  return ok;
+}
+
+// sends the seq of the last status message taken into account (see sendSnapshot()) via MQTT,
+// it goes out right before every status update, so a controller knows which of its messages the update shows
+void sendStatusSeq() {
+  char seq[12];
+  sprintf(seq, "%lu", (unsigned long) status_seq);
+  controlNode.setProperty("status-seq").send(seq);
+}
 
 // sends the active status via MQTT
+// the string is built in a preallocated buffer, so there is no heap growing with each char
 void sendStatus() {
-  String s = "";
-  // yes, there might be better ways to do this...
-  for (int i=0; i<NUM_LEDS_MAX; i++) {
-    s+=POSSIBLE_STATES[state[i]];
+  sendStatusSeq();
+  char* s = statusString;
+  for (int i=0; i<led_count; i++) {
+    s[i] = stateChar(state[i]);
+    statePublished[i] = state[i];
   }
+  s[led_count] = 0;
   controlNode.setProperty("status").send(s);
+  status_dirty = false;
+  status_last_sent = millis();
 }
 
-// simply returns true if the given string is numeric (either integer or decimal)
-boolean isNumeric(String str) {
-  unsigned int stringLength = str.length();
-  if (stringLength == 0) return false;
+// sends only the states changed since the last status update via MQTT
+// the format is the same as accepted by statusHandler(): n1=M1;n2=M2;...
+// if the changes do not fit into the status buffer, the full status is sent instead
+void sendStatusDelta() {
+  char* s = statusString;
+  char* p = s;
+  for (int i=0; i<led_count; i++) {
+    if (statePublished[i] != state[i]) {
+      char pair[12];
+      int l = sprintf(pair, "%s%d=%c", (p != s) ? ";" : "", i, stateChar(state[i]));
+      if (p + l > s + led_count) {
+        sendStatus();
+        return;
+      }
+      memcpy(p, pair, l);
+      p += l;
+    }
+  }
+  *p = 0;
+  for (int i=0; i<led_count; i++) {
+    statePublished[i] = state[i];
+  }
+  if (p != s) {
+    sendStatusSeq();
+    controlNode.setProperty("status-delta").send(s);
+  }
+  status_dirty = false;
+  status_last_sent = millis();
+}
 
-  boolean seenDecimal = false;
-  for(unsigned int i = 0; i < stringLength; ++i) {
-    if (isDigit(str.charAt(i))) continue;
-    if (str.charAt(i) == '.') {
-      if (seenDecimal) return false;
-      seenDecimal = true;
-      continue;
+// sends "<seq>:<status>" via MQTT after every (re)connect, the states in the same format as the status
+// seq counts the status and binary messages received since boot, accepted or rejected (it starts over after a reboot),
+// so a controller numbering its messages the same way knows which of them arrived and only has to send the ones after
+// seq again (or just the states that differ) instead of replaying everything
+void sendSnapshot() {
+  char* s = statusString;
+  int l = sprintf(s, "%lu:", (unsigned long) status_seq);
+  for (int i=0; i<led_count; i++) {
+    s[l + i] = stateChar(state[i]);
+  }
+  s[l + led_count] = 0;
+  controlNode.setProperty("snapshot").send(s);
+}
+
+// adds the cycles since start to t, the cycle counter is read directly so this costs next to nothing
+void addTiming(Timing &t, uint32_t start) {
+  uint32_t cycles = ESP.getCycleCount() - start;
+  t.count++;
+  t.total += cycles;
+  if (cycles > t.max) t.max = cycles;
+}
+
+// publishes one timing as "average/maximum" in microseconds
+void sendTiming(const char* property, const Timing &t) {
+  uint32_t mhz = ESP.getCpuFreqMHz();
+  uint32_t average = (t.count > 0) ? t.total / t.count : 0;
+  char buffer[24];
+  snprintf(buffer, sizeof(buffer), "%lu/%lu", (unsigned long) (average / mhz), (unsigned long) (t.max / mhz));
+  statsNode.setProperty(property).send(buffer);
+}
+
+// publishes a counter pair as "accepted/rejected"
+void sendMessageCount(const char* property, uint32_t accepted, uint32_t rejected) {
+  char buffer[24];
+  snprintf(buffer, sizeof(buffer), "%lu/%lu", (unsigned long) accepted, (unsigned long) rejected);
+  statsNode.setProperty(property).send(buffer);
+}
+
+// publishes the performance counters collected since the last time and starts over
+// loops and fps are per second, the timings in microseconds
+// nothing is published while memory is critical, the property strings would need the heap
+void sendStats() {
+  uint32_t elapsed = millis() - stats.since;
+  if (Homie.isConnected() && (elapsed > 0) && (memory_level < MEMORY_CRITICAL)) {
+    statsNode.setProperty("loops").send(String((uint32_t) ((uint64_t) stats.loops * 1000 / elapsed)));
+    statsNode.setProperty("fps").send(String((stats.frame_time > 0) ? (stats.frames * 1000) / stats.frame_time : 0));
+    sendTiming("fading", stats.fading);
+    sendTiming("show", stats.show);
+    sendTiming("homie", stats.homie);
+    sendTiming("handlers", stats.handlers);
+    statsNode.setProperty("free-heap").send(String(ESP.getFreeHeap()));
+    statsNode.setProperty("max-free-block").send(String(ESP.getMaxFreeBlockSize()));
+    sendMessageCount("status-messages", stats.status_accepted, stats.status_rejected);
+    sendMessageCount("mapping-messages", stats.mapping_accepted, stats.mapping_rejected);
+    sendMessageCount("binary-messages", stats.binary_accepted, stats.binary_rejected);
+    statsNode.setProperty("min-free-heap").send(String(min_free_heap));
+    statsNode.setProperty("free-stack").send(String(ESP.getFreeContStack()));
+    sendMessageCount("memory-events", memory_low_count, memory_critical_count);
+  }
+  memset(&stats, 0, sizeof(stats));
+  stats.since = millis();
+}
+
+// the stats are only collected for publishing if there is an interval for it
+void updateStatsInterval() {
+  if (stats_interval > 0) {
+    tasks[TASK_STATS].interval = stats_interval * 1000UL;
+    memset(&stats, 0, sizeof(stats));
+    stats.since = millis();
+    scheduleTask(TASK_STATS, tasks[TASK_STATS].interval);
+  } else {
+    tasks[TASK_STATS].pending = false;
+  }
+}
+
+// returns the milliseconds between two status updates, longer than status_interval while memory is low
+// (each update is a full copy of the status in the MQTT client's buffers)
+uint32_t statusInterval() {
+  uint32_t interval = (memory_level == MEMORY_CRITICAL) ? 4 * MEMORY_STATUS_INTERVAL
+                    : (memory_level == MEMORY_LOW) ? MEMORY_STATUS_INTERVAL : 0;
+  return (status_interval > interval) ? status_interval : interval;
+}
+
+// remember that state[] changed, the status update itself is sent by flushStatus()
+// (and writing the states to flash by flushStates())
+void statusChanged() {
+  status_dirty = true;
+  states_dirty = true;
+  wakeTask(TASK_STATUS, remaining(status_last_sent, statusInterval()));
+  wakeTask(TASK_STATES, remaining(states_last_saved, STATES_SAVE_INTERVAL));
+}
+
+// sends a pending status update, but not more often than every status_interval milliseconds
+// the first change after a quiet period is sent right away, any further changes within
+// the interval are collected and sent together when it is over
+// while MQTT is down the update stays pending, the full status is sent once we are connected again (see onHomieEvent())
+void flushStatus() {
+  if (!status_dirty || !Homie.isConnected()) return;
+  uint32_t left = remaining(status_last_sent, statusInterval());
+  if (left > 0) {
+    wakeTask(TASK_STATUS, left);    // the interval got longer since the update was scheduled
+  } else if (status_delta) {
+    sendStatusDelta();
+  } else {
+    sendStatus();
+  }
+}
+
+// sends all the settings of the config node via MQTT
+void sendConfig() {
+  configNode.setProperty("brightness-low").send(String(brightness_low));
+  configNode.setProperty("brightness-high").send(String(brightness_high));
+  configNode.setProperty("brightness-cold").send(String(brightness_cold));
+  configNode.setProperty("cool-down-time").send(String(cool_down_time));
+  configNode.setProperty("sensor-curve").send(String(sensor_curve_calibration, 3));
+  configNode.setProperty("status-interval").send(String(status_interval));
+  configNode.setProperty("status-delta").send(status_delta ? "true" : "false");
+  configNode.setProperty("dither-refresh").send(String(dither_refresh));
+  configNode.setProperty("frames-per-second").send(String(frames_per_second));
+  configNode.setProperty("stats-interval").send(String(stats_interval));
+}
+
+// Homie tells us about connection changes here
+// after every (re)connect the snapshot and the full status are sent (whatever status_delta is),
+// so controllers and delta updates have something to start from, changes while we were offline are in there as well
+void onHomieEvent(const HomieEvent& event) {
+  switch (event.type) {
+    case HomieEventType::MQTT_READY:
+      sendSnapshot();
+      sendStatus();
+      sendConfig();
+      break;
+    default:
+      break;
+  }
+}
+
+// calculates the light sensor curve, this is the only place with floating point math for it
+// (only needed at boot and when sensor_curve_calibration changes)
+void buildSensorCurve() {
+  for (int i = 0; i <= SENSOR_CURVE_STEPS; i++) {
+    sensorCurve[i] = pow((float) i / SENSOR_CURVE_STEPS, sensor_curve_calibration) * 255 + 0.5;
+  }
+}
+
+// the cooling steps are spread so that full heat cools down to brightness_cold in cool_down_time seconds
+void updateCoolingInterval() {
+  uint32_t interval = ((uint32_t) cool_down_time * 1000) / (255 - brightness_cold);
+  tasks[TASK_COOLING].interval = (interval > 0) ? interval : 1;
+}
+
+// refreshes for temporal dithering are only needed with FastLED (and if there is a refresh rate)
+void updateDitherInterval() {
+#ifndef LED_OUTPUT_METHOD
+  if (dither_refresh > 0) {
+    tasks[TASK_DITHER].interval = 1000 / dither_refresh;
+    wakeTask(TASK_DITHER, tasks[TASK_DITHER].interval);
+    return;
+  }
+#endif
+  tasks[TASK_DITHER].pending = false;
+}
+
+// the frame rate only sets how often fades are drawn, their timing depends on millis() alone
+// so it is halved while memory is low (and halved again if it is critical), fades just get coarser
+void updateFrameInterval() {
+  tasks[TASK_FADING].interval = (1000 / frames_per_second) << memory_level;
+}
+
+// checks free heap once per loop and fragmentation (the largest free block) every BLOCK_CHECK_INTERVAL, crashing would
+// take us through the whole boot and self-test, so while memory is tight we do less instead (see MemoryLevel)
+// getMaxFreeBlockSize() walks the heap with interrupts disabled, in between the last block is taken (it can't be
+// larger than the free heap, so it shrinks with it right away)
+// changes of the level are published to stats/memory as "<level>:<free heap>/<largest free block>"
+void checkMemory() {
+  uint32_t heap = ESP.getFreeHeap();
+  if ((max_free_block == 0) || (remaining(block_checked, BLOCK_CHECK_INTERVAL) == 0)) {
+    max_free_block = ESP.getMaxFreeBlockSize();
+    block_checked = millis();
+  }
+  if (max_free_block > heap) max_free_block = heap;
+  uint32_t block = max_free_block;
+  if ((min_free_heap == 0) || (heap < min_free_heap)) min_free_heap = heap;
+  uint8_t level = ((heap < HEAP_CRITICAL) || (block < BLOCK_CRITICAL)) ? MEMORY_CRITICAL
+                : ((heap < HEAP_LOW) || (block < BLOCK_LOW)) ? MEMORY_LOW : MEMORY_OK;
+  if (level < memory_level) {
+    // better again, but only if it is clearly above the limits (or the level would flap)
+    uint8_t margin = ((heap < HEAP_CRITICAL + MEMORY_HYSTERESIS) || (block < BLOCK_CRITICAL + MEMORY_HYSTERESIS)) ? MEMORY_CRITICAL
+                   : ((heap < HEAP_LOW + MEMORY_HYSTERESIS) || (block < BLOCK_LOW + MEMORY_HYSTERESIS)) ? MEMORY_LOW : MEMORY_OK;
+    level = (margin < memory_level) ? margin : memory_level;
+  }
+  if (level == memory_level) return;
+  if (level == MEMORY_LOW) memory_low_count++;
+  if (level == MEMORY_CRITICAL) {
+    memory_critical_count++;
+    free(binaryBuffer);     // it is allocated again with the next binary message once memory is fine
+    binaryBuffer = NULL;
+  }
+  memory_level = level;
+  updateFrameInterval();
+  if (status_dirty) wakeTask(TASK_STATUS, remaining(status_last_sent, statusInterval()));
+  if (Homie.isConnected()) {
+    char buffer[32];
+    snprintf(buffer, sizeof(buffer), "%s:%lu/%lu", MEMORY_NAMES[level], (unsigned long) heap, (unsigned long) block);
+    statsNode.setProperty("memory").send(buffer);
+  }
+}
+
+// text messages are already in a String when the handlers get them, but while memory is critical
+// long ones are rejected before they make us publish, allocate or write anything
+bool payloadTooLarge(const String& value) {
+  return (memory_level == MEMORY_CRITICAL) && (value.length() > MEMORY_PAYLOAD_MAX);
+}
+
+// true if FastLED does temporal dithering, only then it has to scale the overall brightness itself
+bool dithering() {
+#ifdef LED_OUTPUT_METHOD
+  return false;
+#else
+  return dither_refresh > 0;
+#endif
+}
+
+// puts the overall brightness into gammaCurve[] (or into FastLED, if it is dithering) and redraws all states
+void applyBrightness() {
+  bool dither = dithering();
+  buildGammaCurve(dither ? 255 : brightness);
+  FastLED.setBrightness(dither ? brightness : 255);
+  activateAllSlots();
+  frame_dirty = true;
+}
+
+// sets the overall brightness from the averaged sensor readings
+// small changes are ignored so the brightness does not flicker between two values,
+// unless force is set (e.g. because the brightness settings changed)
+void updateBrightness(bool force = false) {
+  uint8_t average = ((uint32_t) sensor_average + 128) >> 8;       // rounded, the average creeps up from below
+  uint8_t target = brightness_low + scale8(brightness_high - brightness_low, average);
+  if (target == brightness) return;
+  if (!force && (abs(target - brightness) < BRIGHTNESS_HYSTERESIS)
+      && (target != brightness_low) && (target != brightness_high)) return;
+  brightness = target;
+  applyBrightness();
+}
+
+// reads the light sensor and calculates the new brightness
+void getLightSensor() {
+  uint16_t reading = analogRead(LIGHT_SENSOR);                // get light level (0..1024, it reads 1024 when saturated)
+  // exponential function to correct light detecting curve, interpolated between the steps
+  const uint8_t step_size = 1024 / SENSOR_CURVE_STEPS;
+  uint8_t i = reading / step_size;
+  uint8_t f = reading % step_size;
+  if (i >= SENSOR_CURVE_STEPS) {      // 1024 is the end of the last step, not a step of its own beyond the table
+    i = SENSOR_CURVE_STEPS - 1;
+    f = step_size;
+  }
+  int16_t corrected = sensorCurve[i] + ((sensorCurve[i + 1] - sensorCurve[i]) * f) / step_size;
+  // insert into moving average
+  int32_t difference = (corrected << 8) - (int32_t) sensor_average;
+  sensor_average += difference >> SENSOR_AVERAGE_SHIFT;
+  updateBrightness();
+
+  // read often while the light changes, back off step by step while it is stable
+  // (analogRead() on the ESP8266 disturbs WiFi if done too often)
+  uint32_t &interval = tasks[TASK_SENSOR].interval;
+  if (abs(difference) > (SENSOR_STABLE_DELTA << 8)) {
+    interval = SENSOR_INTERVAL_FAST;
+  } else if (interval < SENSOR_INTERVAL_SLOW) {
+    interval = min(interval * 2, (uint32_t) SENSOR_INTERVAL_SLOW);
+  }
+}
+
+// header of the configuration file, followed by stateColor[], stateFadeTime[], stateEffect[]
+// and led_count mapping and group entries
+struct ConfigHeader {
+  uint32_t magic;
+  uint32_t checksum;          // FNV-1a over header (with checksum = 0) and everything following
+  uint8_t version;
+  uint8_t reserved;
+  uint16_t led_count;
+  uint8_t brightness_low;
+  uint8_t brightness_high;
+  uint8_t brightness_cold;
+  uint8_t cool_down_time;
+  float sensor_curve_calibration;
+  uint16_t status_interval;
+  uint8_t status_delta;
+  uint8_t dither_refresh;
+  uint8_t frames_per_second;
+  uint8_t stats_interval;
+  uint8_t reserved2[2];
+};
+
+// FNV-1a hash, good enough to detect broken files and unchanged configurations
+uint32_t checksum(uint32_t hash, const void* data, size_t length) {
+  const uint8_t* p = (const uint8_t*) data;
+  while (length--) {
+    hash = (hash ^ *p++) * 16777619;
+  }
+  return hash;
+}
+
+// fills the header with the running configuration and returns the checksum of all of it
+uint32_t configSnapshot(ConfigHeader &h) {
+  memset(&h, 0, sizeof(h));
+  h.magic = CONFIG_MAGIC;
+  h.version = CONFIG_VERSION;
+  h.led_count = led_count;
+  h.brightness_low = brightness_low;
+  h.brightness_high = brightness_high;
+  h.brightness_cold = brightness_cold;
+  h.cool_down_time = cool_down_time;
+  h.sensor_curve_calibration = sensor_curve_calibration;
+  h.status_interval = status_interval;
+  h.status_delta = status_delta;
+  h.dither_refresh = dither_refresh;
+  h.frames_per_second = frames_per_second;
+  h.stats_interval = stats_interval;
+  uint32_t hash = checksum(2166136261, &h, sizeof(h));
+  hash = checksum(hash, stateColor, sizeof(stateColor));
+  hash = checksum(hash, stateFadeTime, sizeof(stateFadeTime));
+  hash = checksum(hash, stateEffect, sizeof(stateEffect));
+  hash = checksum(hash, mapping, led_count * sizeof(uint16_t));
+  return checksum(hash, group, led_count);
+}
+
+// replaces name by the completely written file tmp
+bool replaceFile(const char* tmp, const char* name) {
+  SPIFFS.remove(name);
+  return SPIFFS.rename(tmp, name);
+}
+
+// a file written in the background, FLASH_WRITE_CHUNK bytes per loop, from up to 6 chunks of memory
+// a flash write can take milliseconds (erasing even more), doing all of it at once would stall the frames
+struct FileWriter {
+  File f;
+  const char* tmp;            // written first...
+  const char* name;           // ...and renamed to this once complete
+  struct {
+    const void* data;
+    size_t length;
+  } chunks[6];
+  uint8_t chunk_count;
+  uint8_t chunk;              // chunk written next...
+  size_t offset;              // ...and the bytes of it already written
+  bool active;
+};
+FileWriter configWriter;
+FileWriter statesWriter;
+
+enum WriteResult : uint8_t {
+  WRITE_MORE,       // call writeStep() again
+  WRITE_DONE,       // the file is complete and replaced the old one
+  WRITE_FAILED,
+};
+
+// starts writing the chunks of w to tmp, they have to stay as they are until it is done
+bool startWrite(FileWriter &w, const char* tmp, const char* name) {
+  w.f = SPIFFS.open(tmp, "w");
+  if (!w.f) return false;
+  w.tmp = tmp;
+  w.name = name;
+  w.chunk = 0;
+  w.offset = 0;
+  w.active = true;
+  return true;
+}
+
+// drops a file that is being written, the old one is kept
+void abortWrite(FileWriter &w) {
+  w.f.close();
+  SPIFFS.remove(w.tmp);
+  w.active = false;
+}
+
+// writes the next FLASH_WRITE_CHUNK bytes of w, the file replaces the old one once all chunks are written
+WriteResult writeStep(FileWriter &w) {
+  size_t left = FLASH_WRITE_CHUNK;
+  while ((left > 0) && (w.chunk < w.chunk_count)) {
+    size_t n = w.chunks[w.chunk].length - w.offset;
+    if (n > left) n = left;
+    if (w.f.write((const uint8_t*) w.chunks[w.chunk].data + w.offset, n) != n) {
+      abortWrite(w);
+      return WRITE_FAILED;
     }
+    left -= n;
+    w.offset += n;
+    if (w.offset == w.chunks[w.chunk].length) {
+      w.chunk++;
+      w.offset = 0;
+    }
+  }
+  if (w.chunk < w.chunk_count) return WRITE_MORE;
+  w.f.close();
+  w.active = false;
+  return replaceFile(w.tmp, w.name) ? WRITE_DONE : WRITE_FAILED;
+}
+
+ConfigHeader configHeader;    // header of the configuration being written
+
+// starts writing the configuration to a temporary file, it replaces the old one once it is complete (see flushConfig())
+// so there is always a complete file (loadConfig() falls back to the temporary one)
+bool saveConfig() {
+  commitStaged();     // whatever is staged is part of the configuration already
+  ConfigHeader &h = configHeader;
+  h.checksum = configSnapshot(h);
+  if (h.checksum == config_saved_checksum) return true;   // nothing new, save the flash
+
+  FileWriter &w = configWriter;
+  w.chunks[0] = { &h, sizeof(h) };
+  w.chunks[1] = { stateColor, sizeof(stateColor) };
+  w.chunks[2] = { stateFadeTime, sizeof(stateFadeTime) };
+  w.chunks[3] = { stateEffect, sizeof(stateEffect) };
+  w.chunks[4] = { mapping, led_count * sizeof(uint16_t) };
+  w.chunks[5] = { group, led_count };
+  w.chunk_count = 6;
+  return startWrite(w, CONFIG_FILE_TMP, CONFIG_FILE);
+}
+
+// reads the configuration from flash, anything broken or of another version is ignored
+// mapping entries for leds we do not have are skipped, missing ones stay as they are
+bool loadConfig() {
+  const char* name = SPIFFS.exists(CONFIG_FILE) ? CONFIG_FILE : CONFIG_FILE_TMP;
+  File f = SPIFFS.open(name, "r");
+  if (!f) return false;
+  ConfigHeader h;
+  bool ok = (f.read((uint8_t*) &h, sizeof(h)) == sizeof(h))
+         && (h.magic == CONFIG_MAGIC) && (h.version == CONFIG_VERSION)
+         && (f.size() == sizeof(h) + sizeof(stateColor) + sizeof(stateFadeTime) + sizeof(stateEffect) + h.led_count * (sizeof(uint16_t) + 1));
+  if (!ok) {
+    f.close();
+    return false;
+  }
+  // check everything before using any of it
+  uint32_t stored = h.checksum;
+  h.checksum = 0;
+  uint32_t hash = checksum(2166136261, &h, sizeof(h));
+  uint8_t buffer[64];
+  size_t n;
+  while ((n = f.read(buffer, sizeof(buffer))) > 0) {
+    hash = checksum(hash, buffer, n);
+  }
+  if (hash != stored) {
+    f.close();
     return false;
   }
+  f.seek(sizeof(h));
+  f.read((uint8_t*) stateColor, sizeof(stateColor));
+  for (unsigned int i = 0; i < NUM_STATES; i++) {
+    uint16_t ms;
+    f.read((uint8_t*) &ms, sizeof(ms));
+    setFadeTime(i, ((ms >= 2) && (ms <= FADE_TIME_MAX)) ? ms : FADE_TIME);
+  }
+  f.read((uint8_t*) stateEffect, sizeof(stateEffect));
+  for (unsigned int i = 0; i < NUM_STATES; i++) {
+    if ((stateEffect[i].type >= EFFECT_COUNT) || (stateEffect[i].speed < 1) || (stateEffect[i].speed > 16)) {
+      stateEffect[i] = { EFFECT_NONE, 1 };
+    }
+  }
+  for (uint16_t i = 0; i < h.led_count; i++) {
+    uint16_t m;
+    f.read((uint8_t*) &m, sizeof(m));
+    if (i < led_count) mapping[i] = (m < led_count) ? m : led_count;
+  }
+  for (uint16_t i = 0; i < h.led_count; i++) {
+    uint8_t g;
+    f.read(&g, 1);
+    if (i < led_count) group[i] = g;
+  }
+  f.close();
+  brightness_low = h.brightness_low;
+  brightness_high = h.brightness_high;
+  brightness_cold = h.brightness_cold;
+  cool_down_time = h.cool_down_time;
+  sensor_curve_calibration = h.sensor_curve_calibration;
+  buildSensorCurve();
+  status_interval = h.status_interval;
+  status_delta = h.status_delta;
+  dither_refresh = h.dither_refresh;
+  FastLED.setDither( dither_refresh > 0 );
+  if (h.frames_per_second > 0) frames_per_second = h.frames_per_second;
+  updateCoolingInterval();
+  updateDitherInterval();
+  updateFrameInterval();
+  applyBrightness();
+  stats_interval = h.stats_interval;
+  updateStatsInterval();
+  mapping_changed = true;
+  activateAllSlots();
+  // the configuration in flash might be for a different led count, so compare what we have now
+  config_saved_checksum = (h.led_count == led_count) ? stored : 0;
   return true;
 }
 
-// change the state of a given position to new_state
-// but do nothing if it is already in that state
-void changeState(uint16_t position, uint8_t new_state) {
-  if (position < led_count) {
-    if (stateFader[position]== NO_FADE) {
-      // no fading going on, so let's set the next state and start the fade
-      if (state[position] != new_state) {
-        stateNext[position] = new_state;
-        stateFader[position] = FRAMES_PER_FADE;
-      }
-    } else {
-      // we are already fading, so let us be careful not to destroy the eye candy smooth fading :-)
-      if (stateFader[position]>0) {
-        // we are still fading out, so we can just change the next state
-        stateNext[position] = new_state;
-      } else {
-        // we are already fading in, so we set the next state and inverse the fading
-        state[position] = stateNext[position];
-        stateNext[position] = new_state;
-        stateFader[position] = -stateFader[position];
-        sendStatus(); // send status because we changed state[]
-      }
-    }
+// remember that the configuration changed, writing it is done by flushConfig()
+void configChanged() {
+  config_dirty = true;
+  config_last_changed = millis();
+  scheduleTask(TASK_CONFIG, CONFIG_SAVE_DELAY);
+}
+
+// writes a changed configuration to flash, once there were no changes for CONFIG_SAVE_DELAY milliseconds
+// the file is written in the background, a chunk with every run of TASK_CONFIG (see writeStep())
+// if the configuration changes meanwhile the file is dropped and written again later
+// while memory is critical the write is put off, SPIFFS needs some heap for it
+void flushConfig() {
+  if (memory_level == MEMORY_CRITICAL) {
+    if (config_dirty || configWriter.active) scheduleTask(TASK_CONFIG, CONFIG_SAVE_DELAY);
+    return;
+  }
+  if (configWriter.active && config_dirty) abortWrite(configWriter);
+  if (configWriter.active) {
+    WriteResult r = writeStep(configWriter);
+    if (r == WRITE_DONE) config_saved_checksum = configHeader.checksum;
+    if (r == WRITE_FAILED) Serial.println(F("Saving configuration failed."));
+  } else if (config_dirty && (millis() - config_last_changed >= CONFIG_SAVE_DELAY)) {
+    config_dirty = false;
+    if (!saveConfig()) Serial.println(F("Saving configuration failed."));
+  } else if (config_dirty) {
+    scheduleTask(TASK_CONFIG, remaining(config_last_changed, CONFIG_SAVE_DELAY));
+  }
+  if (configWriter.active) scheduleTask(TASK_CONFIG, 0);    // next chunk with the next loop
+}
+
+// header of the states file, followed by led_count states
+struct StatesHeader {
+  uint32_t magic;
+  uint32_t checksum;          // FNV-1a over the states
+  uint16_t led_count;
+  uint16_t reserved;
+};
+
+StatesHeader statesHeader;    // header of the states being written
+
+// starts writing state[] to flash the same way as saveConfig() does
+bool saveStates() {
+  StatesHeader &h = statesHeader;
+  h.magic = STATES_MAGIC;
+  h.checksum = checksum(2166136261, state, led_count);
+  h.led_count = led_count;
+  h.reserved = 0;
+  FileWriter &w = statesWriter;
+  w.chunks[0] = { &h, sizeof(h) };
+  w.chunks[1] = { state, led_count };
+  w.chunk_count = 2;
+  return startWrite(w, STATES_FILE_TMP, STATES_FILE);
+}
+
+// restores the states written before the last reboot, they start out cold instead of fading in
+bool loadStates() {
+  const char* name = SPIFFS.exists(STATES_FILE) ? STATES_FILE : STATES_FILE_TMP;
+  File f = SPIFFS.open(name, "r");
+  if (!f) return false;
+  StatesHeader h;
+  bool ok = (f.read((uint8_t*) &h, sizeof(h)) == sizeof(h))
+         && (h.magic == STATES_MAGIC) && (h.led_count == led_count)
+         && (f.size() == sizeof(h) + led_count)
+         && (f.read(stateNext, led_count) == led_count)    // stateNext is a fine buffer while nothing fades
+         && (checksum(2166136261, stateNext, led_count) == h.checksum);
+  f.close();
+  if (!ok) return false;
+  for (int j=0; j<led_count; j++) {
+    if (stateNext[j] >= NUM_STATES) stateNext[j] = 0;
+    state[j] = stateNext[j];
+    statePublished[j] = state[j];
+    heat[j] = brightness_cold;
+  }
+  activateAllSlots();
+  return true;
+}
+
+// writes changed states to flash, but not more often than every STATES_SAVE_INTERVAL milliseconds
+// (in the background and put off while memory is critical, like the configuration)
+void flushStates() {
+  if (memory_level == MEMORY_CRITICAL) {
+    if (states_dirty || statesWriter.active) scheduleTask(TASK_STATES, CONFIG_SAVE_DELAY);
+    return;
+  }
+  if (statesWriter.active && states_dirty) abortWrite(statesWriter);
+  if (statesWriter.active) {
+    if (writeStep(statesWriter) == WRITE_FAILED) Serial.println(F("Saving states failed."));
+  } else if (states_dirty && (millis() - states_last_saved >= STATES_SAVE_INTERVAL)) {
+    states_dirty = false;
+    states_last_saved = millis();
+    if (!saveStates()) Serial.println(F("Saving states failed."));
+  } else if (states_dirty) {
+    scheduleTask(TASK_STATES, remaining(states_last_saved, STATES_SAVE_INTERVAL));
   }
+  if (statesWriter.active) scheduleTask(TASK_STATES, 0);
 }
 
-// this handler takes the new values from MQTT and sets them
-// sending n=M to the payload will change state n (numeric) to state M (alphanumeric, see POSSIBLE_STATES)
-// every change and a payload of "?" will result in a status update via MQTT
+// status messages are timed and counted for the stats node, see applyStatus()
+// a payload of "?" will result in a status update via MQTT
 bool statusHandler(const HomieRange& range, const String& value) {
 //  Serial.println("  controlNode statusHandler called with value:" + value);
+  status_seq++;     // rejected messages count as well, or a controller's numbering would drift
+  if (payloadTooLarge(value)) {
+    stats.status_rejected++;
+    return false;
+  }
+  uint32_t start = ESP.getCycleCount();
+  bool ok = true;
   if (value.equals("?")) {
     // simple status message requested, no change
     sendStatus();
-    return true;
-  }
-
-  int p = value.indexOf("=");
-//  Serial.print("  p:"); Serial.println(p);
-
-  // we start at 1
-  if (p<1) return false;
-  const String v1 = value.substring(0, p);
-  const String v2 = value.substring(p+1);
-//  Serial.println("  v1:" + v1);
-//  Serial.println("  v2:" + v2);
-  if (!isNumeric(v1)) return false;
-  int v = v1.toInt();
-  if (v2.length()!=1) return false;
-  if (!(v<led_count)) return false;
-  if (POSSIBLE_STATES.indexOf(v2)==-1) return false;
-  changeState(v, POSSIBLE_STATES.indexOf(v2));
-  return true;
+  } else {
+    ok = applyStatus(value.c_str());
+  }
+  addTiming(stats.handlers, start);
+  if (ok) stats.status_accepted++; else stats.status_rejected++;
+  return ok;
 }
 
-// this handler takes a new mapping set from MQTT and adjusts led mapping to event slots
-// sending n1;n2;n3;...(nx = numeric, no spaces, just semicolon as seperator
-// will map led1 to slot n1, led2 to n2, ... 
-// If less then led_count values are sent, rest will be black, if more are send, rest is ignored, 
-// any nonnumeric fields will be black
+// mapping messages are timed and counted for the stats node, see applyMapping()
 bool mappingHandler(const HomieRange& range, const String& value) {
 //  Serial.println("  controlNode mappingHandler called with value:" + value);
+  if (payloadTooLarge(value)) {
+    stats.mapping_rejected++;
+    return false;
+  }
+  uint32_t start = ESP.getCycleCount();
+  bool ok = applyMapping(value.c_str());
+  addTiming(stats.handlers, start);
+  if (ok) stats.mapping_accepted++; else stats.mapping_rejected++;
+  return ok;
+}
 
-  int n = 0;
-  int pos_start = 0;
-  int pos_end = 0;
-  while ((n<led_count) && (pos_start <= value.length())) {
-    int p = value.indexOf(";",pos_start);
+// group messages, see applyGroups()
+bool groupsHandler(const HomieRange& range, const String& value) {
+  if (payloadTooLarge(value)) return false;
+  return applyGroups(value.c_str());
+}
 
-    // did we find a semicolon?
-    if (p<1) {
-      // no, so take all the rest of the string
-      pos_end = value.length();
-    } else {
-      // ok, there is a semicolon, let's end the substring there
-      pos_end = p;
-    };
-
-    const String v1 = value.substring(pos_start, pos_end);
-  //  Serial.printf("  we are at led #%d which starts at %d and ends at %d, value is %s\n",n,pos_start,pos_end,v1.c_str());
-    if (!isNumeric(v1)) {
-      // ohoh, no number here, so led will be black
-      mapping[n] = NUM_LEDS_MAX;
-    } else {
-      int v = v1.toInt();
-      if ((v < NUM_LEDS_MAX) && (v >= 0)) {
-        // great, mathing number here, so led will be set to it
-        mapping[n] = v;
-      } else {
-        // ohoh, number is out of scale, so led will be black
-        mapping[n] = NUM_LEDS_MAX;
-      }
-    }
-    n++;
-    pos_start = pos_end + 1;
-  }
-  if (n < led_count) {
-    // we left to early, so let's black out the rest of the leds
-    for (int i = n; i< led_count; i++) {
-      mapping[i] = NUM_LEDS_MAX;
+// binary control messages are taken straight from the MQTT client, Homie would cut them at the first zero byte
+// they may arrive in chunks, which are collected in binaryBuffer (allocated once, with the first message)
+// the whole message is checked first, so a malformed message changes nothing at all
+// while memory is low or critical binaryBuffer is not allocated, the messages are rejected instead
+void onMqttMessage(char* topic, char* payload, AsyncMqttClientMessageProperties properties, size_t len, size_t index, size_t total) {
+  if (strcmp(topic, binaryTopic) != 0) return;
+  if ((binaryBuffer == NULL) && (index == 0) && (memory_level == MEMORY_OK)) binaryBuffer = (uint8_t*) malloc(binary_capacity);
+  if ((binaryBuffer == NULL) || (total > binary_capacity)) {
+    if (index + len == total) {
+      stats.binary_rejected++;
+      status_seq++;
     }
+    return;
   }
+  memcpy(binaryBuffer + index, payload, len);
+  if (index + len < total) return;    // more chunks to come
+  status_seq++;                       // counted like the status messages, see statusHandler()
+  uint32_t start = ESP.getCycleCount();
+  bool ok = parseBinary(binaryBuffer, total, false) && parseBinary(binaryBuffer, total, true);
+  addTiming(stats.handlers, start);
+  if (ok) stats.binary_accepted++; else stats.binary_rejected++;
+}
+
+// Homie gets the binary messages as well, but they are handled in onMqttMessage()
+bool binaryHandler(const HomieRange& range, const String& value) {
   return true;
 }
 
-// calculate the colors and especially their values (in HSV mode)
-// it respects and calculates the fading from one to the next state
-// full heat is applied after zero is crossed
-void doFading() {
-  for (int j=0; j<NUM_LEDS_MAX; j++) {
-    if (stateFader[j]!= NO_FADE) {
-      // ok, we are fading
-      if (stateFader[j]>0) {
-        // we are still fading out, keep going
-        CHSV c = stateColor[state[j]];
-        c.val = map(stateFader[j],0,FRAMES_PER_FADE,0,c.val);
-        c.val = map(heat[j],0,255,0,c.val);
-        ledsUnmapped[j] = c;
-        stateFader[j]--;
-      } else {
-        // we have crossed zero and are fading in, so heat to the max
-        heat[j] = 255;
-        CHSV c = stateColor[stateNext[j]];
-        c.val = map(stateFader[j],0,-FRAMES_PER_FADE,0,c.val);
-        c.val = map(heat[j],0,255,0,c.val);
-        ledsUnmapped[j] = c;
-        stateFader[j]--;
-      }
-      if (stateFader[j]< -FRAMES_PER_FADE) {
-        // ok, fading is done, target color reached
-        state[j] = stateNext[j];
-        CHSV c = stateColor[state[j]];
-        c.val = map(heat[j],0,255,0,c.val);
-        ledsUnmapped[j] = c;
-        stateFader[j] = NO_FADE;
-        sendStatus(); // send status because we changed state[]
-      }
-    } else {
-      // no fading, so take state's color and cool applied to active heat
-      CHSV c = stateColor[state[j]];
-      c.val = map(heat[j],0,255,0,c.val);
-      ledsUnmapped[j] = c;
-    }
+// reads an integer from value and checks it to be within min and max
+// leading zeros make it as long as one likes and the handlers echo it, so it is checked with payloadTooLarge() as well
+bool parseInteger(const String& value, long min, long max, long &result) {
+  if (payloadTooLarge(value)) return false;
+  const char* p = value.c_str();
+  if (!isDigit(*p)) return false;
+  long v = 0;
+  for (; *p; p++) {
+    if (!isDigit(*p)) return false;
+    v = v * 10 + (*p - '0');
+    if (v > max) return false;
   }
+  if (v < min) return false;
+  result = v;
+  return true;
+}
+
+// the following handlers take new settings from MQTT, check and apply them right away
+// every accepted value is sent back and stored in flash
+bool brightnessLowHandler(const HomieRange& range, const String& value) {
+  long v;
+  if (!parseInteger(value, 0, brightness_high, v)) return false;
+  brightness_low = v;
+  updateBrightness(true);
+  configNode.setProperty("brightness-low").send(value);
+  configChanged();
+  return true;
+}
+
+bool brightnessHighHandler(const HomieRange& range, const String& value) {
+  long v;
+  if (!parseInteger(value, brightness_low, 255, v)) return false;
+  brightness_high = v;
+  updateBrightness(true);
+  configNode.setProperty("brightness-high").send(value);
+  configChanged();
+  return true;
+}
+
+bool brightnessColdHandler(const HomieRange& range, const String& value) {
+  long v;
+  if (!parseInteger(value, 0, 254, v)) return false;
+  brightness_cold = v;
   for (int j=0; j<led_count; j++) {
-    leds[j] = rgb2hsv_approximate(CRGB::Black);
-    leds[j] = ledsUnmapped[mapping[j]];
+    // cold is the lowest heat there is, hotter states cool down to it
+    if (heat[j] < brightness_cold) heat[j] = brightness_cold;
   }
+  activateAllSlots();
+  updateCoolingInterval();
+  configNode.setProperty("brightness-cold").send(value);
+  configChanged();
+  return true;
 }
 
-// cool down brightness after changes
-void doCooling() {
-  for (int j=0; j<NUM_LEDS_MAX; j++) {
-    if (heat[j]> brightness_cold) {
-      // simple function to reduce heat to the value of "cold" (brightness calculates linear but is sensed logarithmically)
-      heat[j]--;
+bool coolDownTimeHandler(const HomieRange& range, const String& value) {
+  long v;
+  if (!parseInteger(value, 1, 255, v)) return false;
+  cool_down_time = v;
+  updateCoolingInterval();
+  configNode.setProperty("cool-down-time").send(value);
+  configChanged();
+  return true;
+}
+
+bool sensorCurveHandler(const HomieRange& range, const String& value) {
+  // decimal number, e.g. 0.2
+  if (payloadTooLarge(value)) return false;
+  const char* p = value.c_str();
+  bool seenDigit = false;
+  bool seenDecimal = false;
+  for (; *p; p++) {
+    if (isDigit(*p)) {
+      seenDigit = true;
+    } else if ((*p == '.') && !seenDecimal) {
+      seenDecimal = true;
+    } else {
+      return false;
     }
   }
+  float v = value.toFloat();
+  if (!seenDigit || (v <= 0) || (v > 10)) return false;
+  sensor_curve_calibration = v;
+  buildSensorCurve();
+  updateBrightness(true);
+  configNode.setProperty("sensor-curve").send(value);
+  configChanged();
+  return true;
+}
+
+bool statusIntervalHandler(const HomieRange& range, const String& value) {
+  long v;
+  if (!parseInteger(value, 0, 60000, v)) return false;
+  status_interval = v;
+  configNode.setProperty("status-interval").send(value);
+  configChanged();
+  return true;
+}
+
+bool statusDeltaHandler(const HomieRange& range, const String& value) {
+  if (value.equals("true")) {
+    status_delta = true;
+  } else if (value.equals("false")) {
+    status_delta = false;
+  } else {
+    return false;
+  }
+  configNode.setProperty("status-delta").send(value);
+  configChanged();
+  return true;
+}
+
+bool ditherRefreshHandler(const HomieRange& range, const String& value) {
+  long v;
+  if (!parseInteger(value, 0, 255, v)) return false;
+  dither_refresh = v;
+  FastLED.setDither( dither_refresh > 0 );
+  updateDitherInterval();
+  applyBrightness();
+  configNode.setProperty("dither-refresh").send(value);
+  configChanged();
+  return true;
+}
+
+bool framesPerSecondHandler(const HomieRange& range, const String& value) {
+  long v;
+  if (!parseInteger(value, 1, 200, v)) return false;
+  frames_per_second = v;
+  updateFrameInterval();
+  configNode.setProperty("frames-per-second").send(value);
+  configChanged();
+  return true;
+}
+
+bool statsIntervalHandler(const HomieRange& range, const String& value) {
+  long v;
+  if (!parseInteger(value, 0, 255, v)) return false;
+  stats_interval = v;
+  updateStatsInterval();
+  configNode.setProperty("stats-interval").send(value);
+  configChanged();
+  return true;
+}
+
+// fade time messages are echoed to the config node, see applyFadeTimes()
+bool fadeTimeHandler(const HomieRange& range, const String& value) {
+  if (payloadTooLarge(value)) return false;
+  if (!applyFadeTimes(value.c_str())) return false;
+  configNode.setProperty("fade-time").send(value);
+  return true;
+}
+
+// effect messages are echoed to the config node, see applyEffects()
+bool effectHandler(const HomieRange& range, const String& value) {
+  if (payloadTooLarge(value)) return false;
+  if (!applyEffects(value.c_str())) return false;
+  configNode.setProperty("effect").send(value);
+  return true;
+}
+
+// palette messages are echoed to the config node, see applyPalette()
+bool paletteHandler(const HomieRange& range, const String& value) {
+  if (payloadTooLarge(value)) return false;
+  if (!applyPalette(value.c_str())) return false;
+  configNode.setProperty("palette").send(value);
+  return true;
+}
+
+// returns the segment led j is in
+uint8_t segmentOf(uint16_t j) {
+  uint8_t s = 0;
+  while ((s < LED_SEGMENTS - 1) && (j >= segmentStart[s + 1])) s++;
+  return s;
+}
+
+// puts color c on led j of the next frame, it is marked for showFrame() only if it actually changed
+// FastLED sends leds[] as it is (and blocks while doing so), NeoPixelBus has its own pixel buffer
+// which Show() copies to the DMA (or UART) buffer, so we write right into it and the next frame
+// can be calculated while the last one is still being sent
+void setLed(uint16_t j, const CRGB &c) {
+#ifdef LED_OUTPUT_METHOD
+  RgbColor rgb(c.r, c.g, c.b);
+  if (strip->GetPixelColor(j) == rgb) return;
+  strip->SetPixelColor(j, rgb);
+#else
+  if (leds[j] == c) return;
+  leds[j] = c;
+#endif
+  segment_dirty |= 1 << segmentOf(j);
 }
 
 // setup - see the debug output for documentation
 void setup() {
   Serial.begin(115200);
   Serial.println(F("Starting IoT-Dashboard..."));
-  stateColor[0] = rgb2hsv_approximate(CRGB::Black);
-  stateColor[1] = rgb2hsv_approximate(CRGB::Black);
-  stateColor[2] = rgb2hsv_approximate(CRGB::Red);
-  stateColor[3] = rgb2hsv_approximate(CRGB::Yellow);
-  stateColor[4] = rgb2hsv_approximate(CRGB::Green);
-  stateColor[5] = rgb2hsv_approximate(CRGB::Blue);
-  stateColor[6] = rgb2hsv_approximate(CRGB::Violet);
-
-  delay(500);
-  Serial.print(F("...initializing FastLed ..."));
-  FastLED.addLeds<CHIPSET, LED_PIN, COLOR_ORDER>(leds, NUM_LEDS_MAX+1).setCorrection( UncorrectedColor );
-  FastLED.setBrightness(brightness_high);
-  for (int i=-1; i<=NUM_LEDS_MAX; i++) {
-    for (int j=0; j<NUM_LEDS_MAX; j++) {
-      if (i==j) {
-        leds[j] = CRGB::White;
-      } else {
-        leds[j] = CRGB::Black;
-      }
-      state[j] = 0;
-      stateNext[j] = 0;
-      stateFader[j] = NO_FADE;
-    }
-    if (i <= led_count) {
-      FastLED.show();
-      delay(50);
-    }
+  for (unsigned int i = 0; i < sizeof(DEFAULT_PALETTE) / sizeof(DEFAULT_PALETTE[0]); i++) {
+    stateColor[i] = rgb2hsv_approximate(CRGB(pgm_read_dword(&DEFAULT_PALETTE[i])));
   }
-  for (int i = 0; i<=NUM_LEDS_MAX; i++) {
-    mapping[i] = i;
+  for (unsigned int i = 0; i < NUM_STATES; i++) {
+    setFadeTime(i, FADE_TIME);
+    stateEffect[i] = { EFFECT_NONE, 1 };
   }
-  mapping[NUM_LEDS_MAX] = NUM_LEDS_MAX;
-  FastLED.setDither( 1 );     // activate temporal dithering
-  Serial.println(F("done."));
 
-  delay(100);
   Serial.print(F("...initializing Homie ..."));
   Homie_setFirmware("IoT-Dashboard", "0.1"); // The underscore is not a typo! See Magic bytes
+  ledCountSetting.setDefaultValue(NUM_LEDS_DEFAULT).setValidator([] (long candidate) {
+    return (candidate > 0) && (candidate <= NUM_LEDS_MAX);
+  });
+  fastBootSetting.setDefaultValue(FAST_BOOT);
+  ledSegmentsSetting.setDefaultValue("");
   controlNode.advertise("status").settable(statusHandler); // set a new status 
   controlNode.advertise("mapping").settable(mappingHandler); // set a new led mapping 
-  Homie.setup();
+  controlNode.advertise("groups").settable(groupsHandler); // put states into groups for "gk=M"
+  controlNode.advertise("status-delta"); // changed states only, if status_delta is set
+  controlNode.advertise("snapshot"); // "<seq>:<status>" after every (re)connect
+  controlNode.advertise("status-seq"); // seq of the status update that follows
+  controlNode.advertise("binary").settable(binaryHandler); // frame, mapping and palette in one binary message
+  configNode.advertise("brightness-low").setDatatype("integer").setFormat("0:255").settable(brightnessLowHandler);
+  configNode.advertise("brightness-high").setDatatype("integer").setFormat("0:255").settable(brightnessHighHandler);
+  configNode.advertise("brightness-cold").setDatatype("integer").setFormat("0:254").settable(brightnessColdHandler);
+  configNode.advertise("cool-down-time").setDatatype("integer").setFormat("1:255").setUnit("s").settable(coolDownTimeHandler);
+  configNode.advertise("sensor-curve").setDatatype("float").settable(sensorCurveHandler);
+  configNode.advertise("status-interval").setDatatype("integer").setUnit("ms").settable(statusIntervalHandler);
+  configNode.advertise("status-delta").setDatatype("boolean").settable(statusDeltaHandler);
+  configNode.advertise("palette").settable(paletteHandler);
+  configNode.advertise("dither-refresh").setDatatype("integer").setFormat("0:255").settable(ditherRefreshHandler);
+  configNode.advertise("frames-per-second").setDatatype("integer").setFormat("1:200").settable(framesPerSecondHandler);
+  configNode.advertise("fade-time").settable(fadeTimeHandler);
+  configNode.advertise("effect").settable(effectHandler);
+  configNode.advertise("stats-interval").setDatatype("integer").setFormat("0:255").setUnit("s").settable(statsIntervalHandler);
+  statsNode.advertise("loops").setDatatype("integer");
+  statsNode.advertise("fps").setDatatype("integer");
+  statsNode.advertise("fading").setUnit("us");
+  statsNode.advertise("show").setUnit("us");
+  statsNode.advertise("homie").setUnit("us");
+  statsNode.advertise("handlers").setUnit("us");
+  statsNode.advertise("free-heap").setDatatype("integer").setUnit("B");
+  statsNode.advertise("max-free-block").setDatatype("integer").setUnit("B");
+  statsNode.advertise("status-messages");
+  statsNode.advertise("mapping-messages");
+  statsNode.advertise("binary-messages");
+  statsNode.advertise("min-free-heap").setDatatype("integer").setUnit("B");
+  statsNode.advertise("free-stack").setDatatype("integer").setUnit("B");
+  statsNode.advertise("memory-events");
+  statsNode.advertise("memory");
+  Homie.onEvent(onHomieEvent);
+  Homie.setup();    // reads the settings, connecting is done in Homie.loop()
+  snprintf(binaryTopic, sizeof(binaryTopic), "%s%s/control/binary/set",
+           Homie.getConfiguration().mqtt.baseTopic, Homie.getConfiguration().deviceId);
+  Homie.getMqttClient().onMessage(onMqttMessage);
+  if (IDLE_LIGHT_SLEEP) WiFi.setSleepMode(WIFI_LIGHT_SLEEP);
+  Serial.println(F("done."));
+
+  Serial.print(F("...allocating memory for leds ..."));
+  if (!allocateLeds(ledCountSetting.get())) {
+    Serial.print(F(" not enough memory, falling back to default ..."));
+    if (!allocateLeds(NUM_LEDS_DEFAULT)) {
+      // nothing would work without the buffers, so stop here instead of crashing over and over
+      Serial.println(F(" not even that, halting."));
+      for (;;) delay(1000);
+    }
+  }
+  Serial.printf(" %d leds ...", led_count);
+  binary_capacity = 3 + 2 + led_count + 3 + 2 + 2 * led_count + 3 + 4 * NUM_STATES;   // frame, mapping, palette
+  Serial.println(F("done."));
+
+  // the self-test is done in loop(), so WiFi and MQTT come up in the meantime
+  if (!fastBootSetting.get()) scheduleTask(TASK_SELFTEST, 0);
+
+  Serial.print(F("...initializing FastLed ..."));
+  if (!setupSegments(ledSegmentsSetting.get()) && (LED_SEGMENTS > 1)) Serial.print(F(" splitting leds evenly ..."));
+#ifdef LED_OUTPUT_METHOD
+  strip = new NeoPixelBus<LED_OUTPUT_FEATURE, LED_OUTPUT_METHOD>(led_count);
+  strip->Begin();
+#else
+  // one controller per data pin, FastLED[s] is segment s
+  FastLED.addLeds<CHIPSET, LED_PIN, COLOR_ORDER>(leds, segmentStart[1]).setCorrection( UncorrectedColor );
+#ifdef LED_PIN_2
+  FastLED.addLeds<CHIPSET, LED_PIN_2, COLOR_ORDER>(leds + segmentStart[1], segmentStart[2] - segmentStart[1]).setCorrection( UncorrectedColor );
+#endif
+#ifdef LED_PIN_3
+  FastLED.addLeds<CHIPSET, LED_PIN_3, COLOR_ORDER>(leds + segmentStart[2], segmentStart[3] - segmentStart[2]).setCorrection( UncorrectedColor );
+#endif
+#ifdef LED_PIN_4
+  FastLED.addLeds<CHIPSET, LED_PIN_4, COLOR_ORDER>(leds + segmentStart[3], segmentStart[4] - segmentStart[3]).setCorrection( UncorrectedColor );
+#endif
+#endif
+  for (int j=0; j<led_count; j++) {
+    mapping[j] = j;           // state[], stateNext[], heat[] and the bitmasks are zero already
+  }
+  activateAllSlots();         // draw everything once
+  FastLED.setDither( dither_refresh > 0 );  // activate temporal dithering, if we refresh for it
+  updateDitherInterval();
+  applyBrightness();
+  updateStatsInterval();
+  Serial.println(F("done."));
+
+  Serial.print(F("...loading configuration ..."));
+  SPIFFS.begin();
+  if (!loadConfig()) Serial.print(F(" none found, using defaults ..."));
+  if (!loadStates()) Serial.print(F(" no states found ..."));
   Serial.println(F("done."));
 
   pinMode(LIGHT_SENSOR,  INPUT); 
-  avg.clear();
-  avg.addValue(1);
+  buildSensorCurve();
 }
 
-// reads the light sensor and calculates the new brightness
-void getLightSensor() {
-  float reading = analogRead(LIGHT_SENSOR);                   // get light level
-  float square_ratio = reading / 1023.0;                      // normalize sensor value
-  square_ratio = pow(square_ratio, sensor_curve_calibration); // exponential function to correct light detecting curve
-  avg.addValue(square_ratio);                                 // insert into running average
-  FastLED.setBrightness(map(avg.getAverage()*255,0,255,brightness_low,brightness_high));
+// lights one led after the other (and all black at start and end) to check the wiring
+// the states are shown again once this is done
+void doSelfTest() {
+  for (int j=0; j<led_count; j++) {
+    setLed(j, (j == selftest_position) ? CRGB(CHSV(0, 0, gammaCurve[255])) : CRGB::Black);
+  }
+  frame_dirty = true;
+  selftest_position++;
+  if (selftest_position > led_count) {
+    // done, back to the states
+    tasks[TASK_SELFTEST].pending = false;
+    mapping_changed = true;   // copy all leds in the next frame
+    wakeFading();
+  }
+}
+
+// puts the leds out, but only if something changed (or temporal dithering needs a refresh, see TASK_DITHER)
+// (every FastLED.show() blocks for about 30us per led with interrupts disabled)
+// with more data pins only the segments with changed leds are sent, unless the whole frame is dirty
+void showFrame() {
+  if (!frame_dirty && !segment_dirty) return;
+#ifdef LED_OUTPUT_METHOD
+  if (!strip->CanShow()) return;    // the last frame is still on its way, try again with the next loop
+#endif
+  uint32_t start = ESP.getCycleCount();
+#ifdef LED_OUTPUT_METHOD
+  // the changed leds are already in the strip's buffer, brightness included (see setLed() and applyBrightness())
+  strip->Show();
+#else
+  if (frame_dirty || (LED_SEGMENTS == 1)) {
+    FastLED.show();
+  } else {
+    for (uint8_t s = 0; s < LED_SEGMENTS; s++) {
+      if (segment_dirty & (1 << s)) FastLED[s].showLeds(FastLED.getBrightness());
+    }
+  }
+#endif
+  addTiming(stats.show, start);
+  frame_dirty = false;
+  segment_dirty = 0;
+}
+
+// calculates the next frame and keeps track of the frame rate actually reached while fading
+void runFading() {
+  uint32_t start = ESP.getCycleCount();
+  uint32_t now = millis();
+  doFading(now);
+  addTiming(stats.fading, start);
+  if (stats_frame_last != 0) {
+    stats.frames++;
+    stats.frame_time += now - stats_frame_last;
+  }
+  stats_frame_last = tasks[TASK_FADING].pending ? (now | 1) : 0;
+}
+
+// does whatever task id stands for
+void runTask(uint8_t id) {
+  switch (id) {
+    case TASK_SELFTEST: doSelfTest(); break;
+    case TASK_FADING:   runFading(); break;
+    case TASK_COOLING:  doCooling(); break;
+    case TASK_SENSOR:   getLightSensor(); break;
+    case TASK_DITHER:   frame_dirty = true; break;
+    case TASK_STATUS:   flushStatus(); break;
+    case TASK_CONFIG:   flushConfig(); break;
+    case TASK_STATES:   flushStates(); break;
+    case TASK_STATS:    sendStats(); break;
+    case TASK_EXPIRY:   doExpiry(); break;
+  }
 }
 
 // let the show begin
 void loop() {
+  uint32_t start = ESP.getCycleCount();
   Homie.loop();  // do the "Homie" thing
-  EVERY_N_MILLIS((cool_down_time * 1000) / (255 - brightness_cold)) { 
-    doCooling();
+  addTiming(stats.homie, start);
+  stats.loops++;
+  checkMemory(); // the MQTT handlers ran while we yielded, so this sees what they (and Homie.loop()) left
+  uint32_t wait = runTasks();
+  showFrame();   // whatever the tasks changed
+  if (wait > 0) {
+    delay(wait);  // nothing to do, so let WiFi (and the CPU) rest until the next task is due
   }
-  EVERY_N_MILLIS(100) {
-    getLightSensor();
-  }
-  EVERY_N_MILLIS(1000 / FRAMES_PER_SECOND) {
-    doFading();
-  }
-  FastLED.show(); // put this outside the per frame function to make temporal dithering smooth
-}
\ No newline at end of file
+}
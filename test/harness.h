@@ -0,0 +1,162 @@
+// what src/main.cpp does around the core, boiled down for the host: a clock of our own, the tasks which
+// render (fading, cooling, expiry) and an output that keeps the frame and a hash of every led change
+// include it once per test program, it has the definitions of the core's hooks (see ledash_core.h)
+
+#include <algorithm>
+#include <chrono>
+#include <vector>
+#include <stdio.h>
+#include "ledash_core.h"
+
+#define HARNESS_FRAMES_PER_SECOND 50
+#define HARNESS_COOL_DOWN_TIME 40
+
+uint32_t harness_millis = 0;           // the clock, only run() moves it
+uint32_t harness_hash = 2166136261UL;  // FNV-1a of every led change (time, led and color), see setLed()
+uint32_t harness_led_changes = 0;
+uint32_t harness_status_changes = 0;   // calls of statusChanged() and configChanged()
+uint32_t harness_config_changes = 0;
+
+// time spent in doFading(), in nanoseconds of the host, and the longest wait for a frame which was due
+// the budgets are checked against the median, the scheduler of the host now and then stalls a frame for milliseconds
+struct FrameTiming {
+  uint32_t frames;
+  uint64_t total;
+  uint64_t max;
+  std::vector<uint32_t> each;
+  uint32_t last;        // millis() of the last frame, if it left more frames to do
+  bool more;
+  uint32_t max_gap;     // milliseconds
+};
+FrameTiming harness_frames;
+
+Task tasks[TASK_COUNT] = {
+  { 0, 0, false },
+  { 1000 / HARNESS_FRAMES_PER_SECOND, 0, false },
+  { (HARNESS_COOL_DOWN_TIME * 1000) / (255 - BRIGHTNESS_COLD), 0, false },
+};
+
+uint32_t millis() {
+  return harness_millis;
+}
+
+uint64_t nanos() {
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+void runTask(uint8_t id) {
+  switch (id) {
+    case TASK_FADING: {
+      uint64_t start = nanos();
+      if (harness_frames.more && (millis() - harness_frames.last > harness_frames.max_gap)) {
+        harness_frames.max_gap = millis() - harness_frames.last;
+      }
+      doFading(millis());
+      uint64_t t = nanos() - start;
+      harness_frames.frames++;
+      harness_frames.total += t;
+      if (t > harness_frames.max) harness_frames.max = t;
+      harness_frames.each.push_back(t);
+      harness_frames.last = millis();
+      harness_frames.more = tasks[TASK_FADING].pending;
+      break;
+    }
+    case TASK_COOLING: doCooling(); break;
+    case TASK_EXPIRY:  doExpiry();  break;
+  }
+}
+
+// the median of times (which it sorts)
+uint64_t median(std::vector<uint32_t> &times) {
+  if (times.empty()) return 0;
+  std::sort(times.begin(), times.end());
+  return times[times.size() / 2];
+}
+
+void statusChanged() {
+  harness_status_changes++;
+}
+
+void configChanged() {
+  harness_config_changes++;
+}
+
+void hashBytes(const void* data, size_t length) {
+  const uint8_t* p = (const uint8_t*) data;
+  for (size_t i = 0; i < length; i++) {
+    harness_hash ^= p[i];
+    harness_hash *= 16777619UL;
+  }
+}
+
+// the frame is only needed for the hash, leds[] keeps it like FastLED would
+void setLed(uint16_t j, const CRGB &c) {
+  if (leds[j] == c) return;
+  leds[j] = c;
+  uint8_t change[9] = { (uint8_t) harness_millis, (uint8_t) (harness_millis >> 8), (uint8_t) (harness_millis >> 16),
+                        (uint8_t) (harness_millis >> 24), (uint8_t) j, (uint8_t) (j >> 8), c.r, c.g, c.b };
+  hashBytes(change, sizeof(change));
+  harness_led_changes++;
+}
+
+// a dashboard of count leds as setup() leaves it with the defaults
+void setupDashboard(uint16_t count) {
+  free(mapping);            // everything allocateLeds() hands out is one block, starting with mapping
+  free(mappingStaged);
+  mapping = NULL;
+  mappingStaged = NULL;
+  mapping_staged = false;
+  palette_staged = false;
+  expiry_count = 0;
+  expiry_seconds = 0;
+  expiry_seconds_last = harness_millis;
+  for (uint8_t id = 0; id < TASK_COUNT; id++) tasks[id].pending = false;
+  if (!allocateLeds(count)) {
+    printf("no memory for %d leds\n", count);
+    exit(1);
+  }
+  const uint32_t palette[] = { 0x000000, 0x000000, 0xff0000, 0xffff00, 0x008000, 0x0000ff, 0xee82ee };
+  for (unsigned int i = 0; i < NUM_STATES; i++) {
+    stateColor[i] = rgb2hsv_approximate(CRGB(i < 7 ? palette[i] : 0));
+    setFadeTime(i, FADE_TIME);
+    stateEffect[i] = { EFFECT_NONE, 1 };
+  }
+  for (int j = 0; j < led_count; j++) mapping[j] = j;
+  mapping_changed = true;
+  buildGammaCurve(255);
+  activateAllSlots();
+  harness_hash = 2166136261UL;
+  harness_led_changes = 0;
+  harness_status_changes = 0;
+  harness_config_changes = 0;
+  harness_frames = FrameTiming();
+}
+
+// lets ms milliseconds pass, running the tasks when they are due (like loop() does)
+void run(uint32_t ms) {
+  uint32_t end = harness_millis + ms;
+  while ((int32_t) (end - harness_millis) > 0) {
+    uint32_t wait = runTasks();
+    if (wait == 0) wait = 1;
+    if ((int32_t) (end - harness_millis) < (int32_t) wait) wait = end - harness_millis;
+    harness_millis += wait;
+  }
+}
+
+// hands payload to the core like the handler of the property ("control/status", "config/palette", ...) does
+// returns false if the message was rejected (or the property is none the core takes)
+bool deliver(const char* property, const char* payload) {
+  if (strcmp(property, "control/status") == 0) return (strcmp(payload, "?") == 0) || applyStatus(payload);
+  if (strcmp(property, "control/mapping") == 0) return applyMapping(payload);
+  if (strcmp(property, "control/groups") == 0) return applyGroups(payload);
+  if (strcmp(property, "config/fade-time") == 0) return applyFadeTimes(payload);
+  if (strcmp(property, "config/effect") == 0) return applyEffects(payload);
+  if (strcmp(property, "config/palette") == 0) return applyPalette(payload);
+  return false;
+}
+
+void setUp() {
+}
+
+void tearDown() {
+}
@@ -0,0 +1,155 @@
+// frame and parse cost of the core at 20, 300 and 1000 leds, run with "pio test -e native -f test_bench"
+// the numbers are host nanoseconds, the ESP8266 at 80 MHz is some 20 to 50 times slower, so they are only
+// good for comparing two builds on the same machine, the budgets are per led (or per byte) and generous:
+// they don't catch a slightly slower build, but anything which isn't linear in the leds any more
+
+#include <string>
+#include <unity.h>
+#include "../harness.h"
+
+#define FRAME_NS_PER_LED 1000     // budget of a frame while all leds fade
+#define PARSE_NS_PER_BYTE 200     // budget of a message (or per led, for those which touch all leds)
+#define PARSE_REPEAT 50           // each message is applied this often, the median is taken
+#define GAMMA_NS 20000            // budget of rebuilding the gamma curve for a brightness step
+
+uint16_t bench_leds;     // leds of the test being run
+
+void report(const char* what, uint64_t ns, uint32_t per, const char* unit) {
+  char line[128];
+  snprintf(line, sizeof(line), "%4d leds, %-18s %8.1f us (%.1f ns per %s)", bench_leds, what, ns / 1000.0,
+           (double) ns / per, unit);
+  TEST_MESSAGE(line);
+}
+
+// every led fades twice a second, which keeps all of them fading (and cooling) in every frame
+void benchFrames(uint16_t count) {
+  bench_leds = count;
+  setupDashboard(count);
+  run(100);
+  std::string frame[2] = { std::string(count, '2'), std::string(count, '5') };
+  harness_frames = FrameTiming();
+  for (int i = 0; i < 20; i++) {
+    TEST_ASSERT_TRUE(applyStatus(frame[i & 1].c_str()));
+    run(500);
+  }
+  TEST_ASSERT_GREATER_THAN(400, harness_frames.frames);
+  uint64_t typical = median(harness_frames.each);
+  report("fading frame", typical, count, "led");
+  report("slowest frame", harness_frames.max, count, "led");
+  TEST_ASSERT_LESS_THAN_UINT64((uint64_t) FRAME_NS_PER_LED * count, typical);
+
+  // cooling only, the fades are over
+  run(2000);
+  harness_frames = FrameTiming();
+  run(5000);
+  if (harness_frames.frames > 0) report("cooling frame", median(harness_frames.each), count, "led");
+}
+
+// applies message a and b in turns (so each one changes something) and returns the median nanoseconds
+uint64_t benchMessage(bool (*apply)(const char*), const std::string &a, const std::string &b) {
+  std::vector<uint32_t> times;
+  for (int i = 0; i < PARSE_REPEAT; i++) {
+    const std::string &m = (i & 1) ? b : a;
+    uint64_t start = nanos();
+    bool ok = apply(m.c_str());
+    times.push_back(nanos() - start);
+    TEST_ASSERT_TRUE(ok);
+    run(5);
+  }
+  return median(times);
+}
+
+// per is the bytes of the message, or the leds if it touches all of them anyway
+void benchParse(const char* what, bool (*apply)(const char*), const std::string &a, const std::string &b, uint32_t per = 0) {
+  uint64_t ns = benchMessage(apply, a, b);
+  report(what, ns, per ? per : a.length(), per ? "led" : "byte");
+  TEST_ASSERT_LESS_THAN_UINT64((uint64_t) PARSE_NS_PER_BYTE * (per ? per : a.length()), ns);
+}
+
+void benchParsing(uint16_t count) {
+  bench_leds = count;
+  setupDashboard(count);
+  run(100);
+  std::string frame[2] = { std::string(count, 'a'), std::string(count, 'x') };
+  benchParse("full frame", applyStatus, frame[0], frame[1]);
+
+  std::string pairs[2], ttl, mapping[2], hex[2], groups;
+  char field[32];
+  for (int j = 0; j < count; j++) {
+    const char* sep = (j > 0) ? ";" : "";
+    snprintf(field, sizeof(field), "%s%d=a", sep, j);  pairs[0] += field;
+    snprintf(field, sizeof(field), "%s%d=x", sep, j);  pairs[1] += field;
+    snprintf(field, sizeof(field), "%s%d=4@60", sep, j);  ttl += field;
+    snprintf(field, sizeof(field), "%s%d", sep, j);  mapping[0] += field;
+    snprintf(field, sizeof(field), "%s%d", sep, count - 1 - j);  mapping[1] += field;
+    snprintf(field, sizeof(field), "%04x", j);  hex[0] += field;
+    snprintf(field, sizeof(field), "%04x", count - 1 - j);  hex[1] += field;
+  }
+  benchParse("n=M pairs", applyStatus, pairs[0], pairs[1]);
+  benchParse("n=M@ttl pairs", applyStatus, ttl, pairs[0]);
+  benchParse("mapping", applyMapping, mapping[0], mapping[1]);
+  benchParse("mapping (hex)", applyMapping, "x" + hex[0], "x" + hex[1]);
+  snprintf(field, sizeof(field), "1=0-%d", count / 2 - 1);
+  groups = field;
+  snprintf(field, sizeof(field), ";2=%d-%d", count / 2, count - 1);
+  groups += field;
+  TEST_ASSERT_TRUE(applyGroups(groups.c_str()));
+  benchParse("gk=M (2 groups)", applyStatus, "g1=a;g2=x", "g1=x;g2=a", count);
+  benchParse("groups", applyGroups, groups, groups, count);
+
+  std::string binary[2];
+  for (int i = 0; i < 2; i++) {
+    binary[i] = std::string("\x01", 1) + (char) ((count + 2) & 0xff) + (char) ((count + 2) >> 8) + std::string(2, '\0') +
+                std::string(count, (char) (i ? 33 : 10));
+  }
+  std::vector<uint32_t> times;
+  for (int i = 0; i < PARSE_REPEAT; i++) {
+    const std::string &m = binary[i & 1];
+    uint64_t start = nanos();
+    bool ok = parseBinary((const uint8_t*) m.data(), m.length(), false) && parseBinary((const uint8_t*) m.data(), m.length(), true);
+    times.push_back(nanos() - start);
+    TEST_ASSERT_TRUE(ok);
+  }
+  uint64_t ns = median(times);
+  report("binary frame", ns, binary[0].length(), "byte");
+  TEST_ASSERT_LESS_THAN_UINT64((uint64_t) PARSE_NS_PER_BYTE * binary[0].length(), ns);
+}
+
+// every change of the light sensor's brightness rebuilds the gamma curve, see buildGammaCurve()
+void test_brightness() {
+  std::vector<uint32_t> times;
+  for (int b = 0; b < 256; b++) {
+    uint64_t start = nanos();
+    buildGammaCurve(b);
+    times.push_back(nanos() - start);
+  }
+  uint64_t ns = median(times);
+  char line[64];
+  snprintf(line, sizeof(line), "brightness step %8.2f us", ns / 1000.0);
+  TEST_MESSAGE(line);
+  TEST_ASSERT_LESS_THAN_UINT64(GAMMA_NS, ns);
+  buildGammaCurve(255);
+  TEST_ASSERT_EQUAL(255, gammaCurve[255]);
+  TEST_ASSERT_EQUAL(0, gammaCurve[0]);
+  buildGammaCurve(1);
+  TEST_ASSERT_EQUAL(1, gammaCurve[1]);     // lit stays lit
+}
+
+void test_frames_20()    { benchFrames(20); }
+void test_frames_300()   { benchFrames(300); }
+void test_frames_1000()  { benchFrames(1000); }
+void test_parsing_20()   { benchParsing(20); }
+void test_parsing_300()  { benchParsing(300); }
+void test_parsing_1000() { benchParsing(1000); }
+
+int main(int argc, char** argv) {
+  UNITY_BEGIN();
+  RUN_TEST(test_frames_20);
+  RUN_TEST(test_frames_300);
+  RUN_TEST(test_frames_1000);
+  RUN_TEST(test_parsing_20);
+  RUN_TEST(test_parsing_300);
+  RUN_TEST(test_parsing_1000);
+  RUN_TEST(test_brightness);
+  return UNITY_END();
+}
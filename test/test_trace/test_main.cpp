@@ -0,0 +1,92 @@
+// replays trace.h at the times it was recorded and checks the frames, run with "pio test -e native -f test_trace"
+// every led change (when, which led, which color) goes into a hash, so a change in what is shown or when it
+// is shown fails the test, if that change was intended the test prints the hash to put into TRACE_HASH
+
+#include <string>
+#include <unity.h>
+#include "../harness.h"
+#include "trace.h"
+
+#define TRACE_HASH 0xF1BEF9C7     // harness_hash after the replay
+#define TRACE_FRAME_NS_PER_LED 1000   // budget of a frame (the median), see test_bench
+
+uint32_t trace_accepted = 0;
+uint32_t trace_rejected = 0;
+uint64_t trace_handler_ns = 0;     // time spent applying the messages
+
+// replays TRACE, each line is "<seconds> <topic> <payload>", the topic ends with "<node>/<property>/set"
+void replay() {
+  setupDashboard(TRACE_LEDS);
+  run(100);
+  uint32_t start = harness_millis;
+  double first = -1;
+  for (const char* line = TRACE; *line; ) {
+    const char* end = strchr(line, '\n');
+    if (end == NULL) end = line + strlen(line);
+    std::string l(line, end);
+    line = (*end) ? end + 1 : end;
+    size_t topic = l.find(' ');
+    size_t payload = (topic == std::string::npos) ? topic : l.find(' ', topic + 1);
+    if (payload == std::string::npos) continue;
+
+    double t = atof(l.c_str());
+    if (first < 0) first = t;
+    uint32_t due = start + (uint32_t) ((t - first) * 1000 + 0.5);
+    if ((int32_t) (due - harness_millis) > 0) run(due - harness_millis);
+
+    std::string property = l.substr(topic + 1, payload - topic - 1);
+    property = property.substr(0, property.rfind("/set"));
+    size_t node = property.rfind('/', property.rfind('/') - 1);
+    property = property.substr(node + 1);
+    uint64_t t0 = nanos();
+    bool ok = deliver(property.c_str(), l.c_str() + payload + 1);
+    trace_handler_ns += nanos() - t0;
+    if (ok) trace_accepted++; else trace_rejected++;
+  }
+  run(70000);       // the last fades, cooling and all the times to live
+}
+
+void test_replay() {
+  replay();
+  char line[160];
+  snprintf(line, sizeof(line), "%u messages (%u rejected) in %.1f us, %u frames, %u led changes, %u status updates",
+           trace_accepted + trace_rejected, trace_rejected, trace_handler_ns / 1000.0, harness_frames.frames,
+           harness_led_changes, harness_status_changes);
+  TEST_MESSAGE(line);
+  snprintf(line, sizeof(line), "frames take %.1f us (%.1f us on average, %.1f us at most), the longest wait for one was %u ms",
+           median(harness_frames.each) / 1000.0, harness_frames.total / 1000.0 / harness_frames.frames,
+           harness_frames.max / 1000.0, harness_frames.max_gap);
+  TEST_MESSAGE(line);
+  TEST_ASSERT_EQUAL(TRACE_MESSAGES, trace_accepted + trace_rejected);
+  TEST_ASSERT_EQUAL(TRACE_REJECTED, trace_rejected);
+  TEST_ASSERT_LESS_THAN_UINT64((uint64_t) TRACE_FRAME_NS_PER_LED * TRACE_LEDS, median(harness_frames.each));
+  TEST_ASSERT_TRUE(harness_frames.max_gap <= tasks[TASK_FADING].interval);
+}
+
+// once the trace is over everything comes to rest: no fades, no frames and the times to live are over
+void test_rest() {
+  TEST_ASSERT_FALSE(tasks[TASK_FADING].pending);
+  TEST_ASSERT_FALSE(tasks[TASK_COOLING].pending);
+  TEST_ASSERT_EQUAL(0, expiry_count);
+  uint16_t stale = 0;
+  for (uint16_t j = 0; j < led_count; j++) {
+    TEST_ASSERT_FALSE(isFading(j));
+    if (state[j] == stateIndex(STALE_STATE)) stale++;
+  }
+  TEST_ASSERT_GREATER_THAN(0, stale);
+}
+
+void test_frames() {
+  char line[64];
+  snprintf(line, sizeof(line), "hash of the led changes is 0x%08X", harness_hash);
+  TEST_MESSAGE(line);
+  TEST_ASSERT_EQUAL_HEX32(TRACE_HASH, harness_hash);
+}
+
+int main(int argc, char** argv) {
+  UNITY_BEGIN();
+  RUN_TEST(test_replay);
+  RUN_TEST(test_rest);
+  RUN_TEST(test_frames);
+  return UNITY_END();
+}
@@ -0,0 +1,309 @@
+// 300 messages to a 144 led wall unit, as "mosquitto_sub -v -t 'homie/wall/+/+/set' | ts '%.s'" writes them
+// (see test/README), 6 of them are malformed and have to be rejected
+
+#define TRACE_LEDS 144
+#define TRACE_MESSAGES 300
+#define TRACE_REJECTED 6
+
+const char TRACE[] = R"(
+1760428800.000000 homie/wall/config/fade-time/set *=1400;x=3000;?=6000
+1760428800.012000 homie/wall/config/palette/set a=00c000;w=ffa000;x=ff0000;?=202040
+1760428800.020000 homie/wall/config/effect/set x=blink:2;w=pulse
+1760428800.031000 homie/wall/control/groups/set 1=0-47;2=48-95;3=96-143
+1760428800.045000 homie/wall/control/mapping/set x0000000100020003000400050006000700080009000a000b000c000d000e000f0010001100120013001400150016001700180019001a001b001c001d001e001f0020002100220023002400250026002700280029002a002b002c002d002e002f0030003100320033003400350036003700380039003a003b003c003d003e003f0040004100420043004400450046004700480049004a004b004c004d004e004f0050005100520053005400550056005700580059005a005b005c005d005e005f008f008e008d008c008b008a0089008800870086008500840083008200810080007f007e007d007c007b007a0079007800770076007500740073007200710070006f006e006d006c006b006a0069006800670066006500640063006200610060
+1760428800.060000 homie/wall/control/status/set aaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaa
+1760428800.500000 homie/wall/control/status/set 101=a;12=x
+1760428800.559316 homie/wall/control/status/set waaaaaaaawaa0aa0a00aaaawaaaawa0awaa00aaawa0a0aawaaa0aaaaaaa0awaaaa0aawaaaaaaaaw0aaa0a0aaaaaaaa0aaaaaaaa0aaaaaaaaaaaaaawaaawaaaaaaaaaaaaa0aaaaaaw
+1760428800.835827 homie/wall/control/status/set aw0aawaaaaaaaaaaaaaaa0aaa0awaa0aaa0aaaa0aaaaaaaaaaaaaaaawaawaawawaaawaaaawwwaa0aaaaawaaaaaaaa0aaaaaaaaaaaaa00aaaaaaaaaaaaaaaaaaaaa0aa00aaawwaaaa
+1760428801.284491 homie/wall/control/status/set 111=a@5
+1760428802.334247 homie/wall/control/status/set 54=a;74=a;128=a
+1760428802.805869 homie/wall/control/status/set 144=a
+1760428804.250750 homie/wall/control/status/set 132=x;107=a;128=x;33=x
+1760428804.262079 homie/wall/control/status/set 1=a;38=a
+1760428804.646973 homie/wall/control/status/set g3=a@20
+1760428805.335021 homie/wall/control/status/set 27=a;143=a;14=a;63=a
+1760428805.760238 homie/wall/control/status/set aaa0w0waaawwawawawaaaaaaaaaaaaaaaaaaaaaaaaaaaaawaaaaaaaaaawaaaaaw0awaaaaaaaaaaaaaaaww0aaaaaaaaaaaaa0aaaaaaawaa0aawaaaaaaaaawaaawaaaaaaaawwawaaaa
+1760428806.404567 homie/wall/control/status/set g3=a@30
+1760428807.484251 homie/wall/control/status/set 78=a;55=w;58=a;87=a;50=a
+1760428807.492866 homie/wall/control/status/set aaaaaawa0aaaaaaaaaaaawaaaaaaaaaaaaawaawaaaaaa0aaaaaaa0wa0aaaaa0aawawaww0a0aaaaaaaaawaawaaaaaawwawaaaaaaaaaaaaaaa0aa0aaaa00aaaaaaaaaawaaaaawaaaaa
+1760428807.698013 homie/wall/control/status/set 115=a;68=a;99=x;53=a;19=a
+1760428807.783369 homie/wall/control/status/set 3=a@0
+1760428807.980111 homie/wall/control/status/set 59=w;127=a;124=a
+1760428807.982270 homie/wall/control/status/set 103=a;77=w;36=a;106=a
+1760428809.082685 homie/wall/control/status/set 101=a;30=a;50=a
+1760428809.362027 homie/wall/control/status/set 19=a;92=a;109=a;70=a;12=a
+1760428809.534096 homie/wall/control/status/set 80=w;48=x;95=x;109=a;7=a
+1760428809.564541 homie/wall/control/status/set g2=w@15
+1760428810.185063 homie/wall/control/status/set 140=a
+1760428810.297413 homie/wall/control/status/set 76=w;65=a;66=a
+1760428810.693452 homie/wall/control/status/set g1=a@30
+1760428810.799248 homie/wall/control/status/set 140=0;56=w;115=a;85=x
+1760428810.927467 homie/wall/control/status/set 142=a;23=a;81=a
+1760428811.921883 homie/wall/control/status/set 105=w
+1760428812.242425 homie/wall/control/status/set 69=a;86=a;15=a;127=x
+1760428812.694451 homie/wall/control/status/set 23=x
+1760428812.698141 homie/wall/control/status/set 98=x
+1760428812.701079 homie/wall/control/status/set 110=x
+1760428812.704625 homie/wall/control/status/set 5=w
+1760428812.705721 homie/wall/control/status/set 121=a
+1760428812.708191 homie/wall/control/status/set 18=x
+1760428812.711982 homie/wall/control/status/set 135=x
+1760428812.715898 homie/wall/control/status/set 63=w
+1760428812.717570 homie/wall/control/status/set 38=a
+1760428812.718661 homie/wall/control/status/set 9=a
+1760428812.721485 homie/wall/control/status/set 27=a
+1760428812.721806 homie/wall/control/status/set 32=a
+1760428812.723561 homie/wall/control/status/set 111=a
+1760428812.724588 homie/wall/control/status/set 117=w
+1760428812.726852 homie/wall/control/status/set 25=w
+1760428812.728754 homie/wall/control/status/set 49=x
+1760428812.730536 homie/wall/control/status/set 0=w
+1760428812.733149 homie/wall/control/status/set 117=x
+1760428812.737025 homie/wall/control/status/set 62=x
+1760428812.739604 homie/wall/control/status/set 140=w
+1760428812.740692 homie/wall/control/status/set 105=a
+1760428812.743641 homie/wall/control/status/set 14=w
+1760428814.015565 homie/wall/control/status/set aaaaaaaaaaaaaaawaaaaaaaaaaaa0a0aaaaa0aaaaa0aaaaaaaaaaaaaawaaaaaaaaaaaaaaaawaaaaaaaaaawaaaaaaaaaaaaaaaaaa0aaaa0aaaaaa0aaaaaaaaaaaaaaaa0aaaaa0awaa
+1760428814.854307 homie/wall/control/status/set 8=0
+1760428815.336881 homie/wall/control/status/set 26=a;18=a;67=w;21=0
+1760428818.012596 homie/wall/control/status/set 44=a@5
+1760428818.098178 homie/wall/control/status/set 60=a;137=a;31=a;75=a;71=0;68=a
+1760428818.221461 homie/wall/control/status/set 48=w;83=a;16=a
+1760428818.646204 homie/wall/control/status/set 118=a
+1760428818.710977 homie/wall/control/status/set 114=a;95=a
+1760428818.870054 homie/wall/control/status/set 49=0;19=a;95=a;131=a;45=a
+1760428819.017322 homie/wall/control/status/set 11=a;52=a
+1760428819.566232 homie/wall/control/status/set g1=a@20
+1760428819.881791 homie/wall/control/status/set 79=x;19=0;52=a;8=w;126=a
+1760428820.835113 homie/wall/control/status/set g1=w@30
+1760428820.892460 homie/wall/control/status/set 69=a;104=a;72=w;78=w;106=a;13=a
+1760428821.512961 homie/wall/control/status/set 52=w;1=a;111=a;40=w
+1760428822.030320 homie/wall/control/status/set 33=a;3=x
+1760428822.122559 homie/wall/control/status/set 22=a
+1760428822.125425 homie/wall/control/status/set 94=a
+1760428822.127939 homie/wall/control/status/set 37=x
+1760428822.129789 homie/wall/control/status/set 133=w
+1760428822.133565 homie/wall/control/status/set 27=x
+1760428822.136037 homie/wall/control/status/set 50=x
+1760428822.137417 homie/wall/control/status/set 11=x
+1760428822.139360 homie/wall/control/status/set 99=w
+1760428822.143073 homie/wall/control/status/set 41=a
+1760428822.146430 homie/wall/control/status/set 56=a
+1760428822.148644 homie/wall/control/status/set 50=x
+1760428822.150193 homie/wall/control/status/set 55=w
+1760428822.152392 homie/wall/control/status/set 132=w
+1760428822.154543 homie/wall/control/status/set 31=w
+1760428822.896893 homie/wall/config/palette/set a=05dd00
+1760428824.005834 homie/wall/control/status/set g3=a@15
+1760428824.302251 homie/wall/control/status/set 78=0;107=x;63=0;108=a;99=a;94=a
+1760428824.881054 homie/wall/control/status/set 114=a;117=0
+1760428825.187892 homie/wall/control/status/set 110=0;93=x;23=x
+1760428825.830075 homie/wall/control/status/set 21=x;80=a
+1760428825.863550 homie/wall/control/status/set 34=a;6=a;16=0;28=a
+1760428827.746471 homie/wall/control/status/set 42=a@5
+1760428827.787128 homie/wall/control/status/set 40=0;82=a;70=a
+1760428828.205684 homie/wall/control/status/set 53=a@6
+1760428828.779742 homie/wall/control/status/set 9=w;50=a;46=a
+1760428829.462803 homie/wall/config/palette/set a=15fb00
+1760428830.384709 homie/wall/control/status/set 12=a;92=a;115=x;142=w;133=a
+1760428830.569239 homie/wall/control/status/set 37=a@7
+1760428830.810268 homie/wall/control/status/set 45=a;12=x
+1760428830.985807 homie/wall/control/status/set 0aaaaaa0aawaaaaa0aaaa0aaawawaa0a0aaa0aaaaaaaaaaaaaaawa00a0waaaaaawaaaaaaaa0waaaaw0wa0awaaaaawaaaaaaaaaaaaaaaaawawaaaawaaaaaaaaaa0aawaawaaaa0aaa0
+1760428831.513973 homie/wall/control/status/set aaaaaa0aaaaaaaaaaa0aawaaaaaaaaaaaaaaaaaaaaaaaaaaaa0waa0aaaawaaaaw0aa0aaaawaaaaaaaaaa0awa0aaaaaaaaawaaaaaaaaaaaaaawwaaaaaw00aa0awaawaaaaa0aaaaawa
+1760428831.700734 homie/wall/control/status/set 39=a
+1760428831.702202 homie/wall/control/status/set 63=a
+1760428831.704182 homie/wall/control/status/set 133=x
+1760428831.705665 homie/wall/control/status/set 83=w
+1760428831.707441 homie/wall/control/status/set 26=w
+1760428831.711328 homie/wall/control/status/set 26=w
+1760428831.713481 homie/wall/control/status/set 37=x
+1760428831.716681 homie/wall/control/status/set 111=x
+1760428831.718269 homie/wall/control/status/set 27=x
+1760428831.719888 homie/wall/control/status/set 99=x
+1760428831.720990 homie/wall/control/status/set 102=x
+1760428831.724071 homie/wall/control/status/set 128=a
+1760428831.725959 homie/wall/control/status/set 5=w
+1760428831.727731 homie/wall/control/status/set 103=w
+1760428831.730954 homie/wall/control/status/set 110=a
+1760428831.733676 homie/wall/control/status/set 107=w
+1760428831.736679 homie/wall/control/status/set 58=a
+1760428831.780315 homie/wall/control/status/set 25=w;107=a;62=a
+1760428832.916358 homie/wall/control/status/set 104=x
+1760428833.591168 homie/wall/control/status/set 46=a@7
+1760428834.494700 homie/wall/control/status/set 27=a;9=a;64=a;139=x
+1760428834.751517 homie/wall/control/status/set g0=a
+1760428835.218786 homie/wall/control/status/set g3=a@30
+1760428836.162554 homie/wall/control/status/set 105=a;116=w;53=x
+1760428837.025616 homie/wall/control/status/set 91=w;14=a;64=a;70=a;97=w
+1760428838.507762 homie/wall/control/status/set a0aaaaawaaaaaaaaawaaaaaawaaaaaaaaaaaaaaaaaaa0aaaaaaa0aawa0aaaaaa0a0aaaaaaaawa00awaaaawaaawaaaaaaawaaaaaaaaw0aaaa0aaaaaaaaaaa0aaawaaaaaaaaaaaawwa
+1760428838.708333 homie/wall/control/status/set 141=a;13=a;74=0
+1760428839.018570 homie/wall/control/status/set 129=0;88=a;52=a
+1760428839.146715 homie/wall/control/status/set g1=w@30
+1760428839.201706 homie/wall/control/status/set 102=a@10
+1760428840.502546 homie/wall/control/status/set 102=a
+1760428840.571456 homie/wall/control/status/set 15=a;128=a;139=a;96=a
+1760428841.231227 homie/wall/control/status/set 25=a;46=w
+1760428842.124981 homie/wall/control/status/set 3=a@7
+1760428843.358051 homie/wall/control/status/set 143=a;66=w;77=a
+1760428843.588106 homie/wall/control/status/set 13=w;127=0;133=a;10=a;30=w;107=a
+1760428843.975233 homie/wall/control/status/set 21=0
+1760428844.118398 homie/wall/control/status/set 109=a
+1760428844.124021 homie/wall/control/status/set g1=a@15
+1760428844.206867 homie/wall/control/status/set 62=a;115=a;47=x;12=0;93=0;37=a
+1760428845.675581 homie/wall/control/status/set 2=a
+1760428845.684484 homie/wall/control/status/set g3=a@20
+1760428845.908047 homie/wall/control/status/set g1=a@30
+1760428845.945031 homie/wall/control/status/set 112=a;120=a;42=w;37=0;29=w
+1760428846.848330 homie/wall/control/status/set 85=a;74=a;71=a
+1760428847.916069 homie/wall/control/status/set a0aaaaa0aaaaaaaaa0aaa0aawaawawwaaaaa0aaaaa0aaawawaaaa0wawaaw0aaaaaaaa00aawaaaaaaaaaaa0aaaw0aaaa0a00aaaaaa00aaaaaaaaaaawaaaa0aaaaa0aawaaaaaaaaaaa
+1760428847.952733 homie/wall/control/status/set aaawaaaaaaaa00aaaaaaaaaaaaaaaaaaaaaa0aaaaaaaaaaaaaaaaaaaawaaaaaaaaaa0aaaaaaaaaaawaawaaaaaaaaaaaaaaaaaaaawawaaawaaaaaaaa0aaawaaa0aa0aaaaa0a0aaaaw
+1760428848.267407 homie/wall/control/status/set g1=w@20
+1760428848.512386 homie/wall/control/status/set g0=a
+1760428848.569190 homie/wall/control/status/set 34=a;68=a;63=a;47=a
+1760428849.082476 homie/wall/control/status/set 7=a;;8=b
+1760428849.522636 homie/wall/control/status/set 18=w;30=a;91=a;62=a;82=0
+1760428849.877466 homie/wall/control/status/set 34=a;5=a;62=a;22=a;57=a
+1760428850.363760 homie/wall/control/status/set 4=a@3
+1760428851.928507 homie/wall/control/status/set g2=a@30
+1760428852.536250 homie/wall/control/status/set 113=a;26=a
+1760428853.293843 homie/wall/control/status/set 119=0
+1760428853.822834 homie/wall/control/status/set 31=w
+1760428853.825051 homie/wall/control/status/set 35=a
+1760428853.827827 homie/wall/control/status/set 58=w
+1760428853.830833 homie/wall/control/status/set 118=a
+1760428853.833023 homie/wall/control/status/set 4=a
+1760428853.835189 homie/wall/control/status/set 107=a
+1760428853.838708 homie/wall/control/status/set 134=w
+1760428853.840895 homie/wall/control/status/set 13=x
+1760428853.842911 homie/wall/control/status/set 61=x
+1760428854.933841 homie/wall/control/status/set aawaawaaaaaaawaaaaawaaaaaaaaa0a0awa0aaawaaaaaaaaaaa0waaa0waaawaaa0aaaawaa00aaawaawa0aaaaaaaawwa0aaaaaawaaaaaaaaawa0aaawaaaawaaaaaaa00awaaaaaaaaw
+1760428855.462734 homie/wall/control/status/set 38=0;106=0;71=a;28=a;97=a
+1760428855.723937 homie/wall/control/status/set 98=0;82=a;1=a;127=x;97=a
+1760428856.698523 homie/wall/control/status/set 59=a;22=a;84=a;82=w
+1760428858.029767 homie/wall/control/status/set 6=a@2
+1760428858.207638 homie/wall/config/palette/set a=26da00
+1760428859.098596 homie/wall/control/status/set 132=a;110=a;99=a;118=0
+1760428860.871349 homie/wall/control/status/set g3=a@15
+1760428861.187440 homie/wall/control/status/set 143=0;39=a;48=x;107=a;124=a;102=a
+1760428861.417144 homie/wall/control/status/set 79=a@10
+1760428861.532993 homie/wall/control/status/set g2=w@20
+1760428862.563724 homie/wall/control/status/set 107=a@4
+1760428863.009198 homie/wall/control/status/set 129=w
+1760428863.011435 homie/wall/control/status/set 15=a
+1760428863.014130 homie/wall/control/status/set 27=x
+1760428863.016840 homie/wall/control/status/set 10=a
+1760428863.019074 homie/wall/control/status/set 0=x
+1760428863.022206 homie/wall/control/status/set 141=w
+1760428863.025957 homie/wall/control/status/set 101=w
+1760428863.028715 homie/wall/control/status/set 7=w
+1760428863.030241 homie/wall/control/status/set 141=a
+1760428863.032039 homie/wall/control/status/set 136=a
+1760428863.036030 homie/wall/control/status/set 50=x
+1760428863.103439 homie/wall/control/status/set 27=x;7=0;25=0;19=w;43=a
+1760428863.733504 homie/wall/control/status/set g3=a@15
+1760428864.487628 homie/wall/control/status/set 8=a;68=a
+1760428864.745077 homie/wall/control/status/set 5=a;13=0;56=a;101=a
+1760428864.917150 homie/wall/control/status/set 44=w;80=a;1=0;116=a;77=a
+1760428865.595736 homie/wall/control/status/set g3=a@20
+1760428865.817642 homie/wall/control/status/set ?
+1760428866.215084 homie/wall/control/status/set 22=w
+1760428866.216594 homie/wall/control/status/set 97=w
+1760428866.217617 homie/wall/control/status/set 74=x
+1760428866.220302 homie/wall/control/status/set 29=x
+1760428866.222903 homie/wall/control/status/set 98=x
+1760428866.225112 homie/wall/control/status/set 16=w
+1760428866.227379 homie/wall/control/status/set 89=a
+1760428866.229114 homie/wall/control/status/set 48=x
+1760428866.230965 homie/wall/control/status/set 60=x
+1760428866.232070 homie/wall/control/status/set 6=x
+1760428866.235484 homie/wall/control/status/set 61=a
+1760428866.346199 homie/wall/control/status/set 142=0;113=a
+1760428866.450256 homie/wall/control/status/set 103=a;96=a;53=0;76=a;121=a;129=0
+1760428866.981660 homie/wall/control/status/set 103=a;130=a
+1760428868.216928 homie/wall/control/status/set 23=a;138=a;69=a;98=w;7=a
+1760428868.928732 homie/wall/control/status/set 82=w
+1760428868.931720 homie/wall/control/status/set 27=w
+1760428868.934406 homie/wall/control/status/set 92=a
+1760428868.937681 homie/wall/control/status/set 49=w
+1760428868.940838 homie/wall/control/status/set 22=w
+1760428868.942703 homie/wall/control/status/set 102=x
+1760428868.944771 homie/wall/control/status/set 118=a
+1760428868.948419 homie/wall/control/status/set 33=x
+1760428868.949949 homie/wall/control/status/set 93=a
+1760428868.953347 homie/wall/control/status/set 89=x
+1760428868.954422 homie/wall/control/status/set 118=w
+1760428869.235754 homie/wall/control/status/set 25=a@4
+1760428869.442497 homie/wall/control/status/set 56=a;10=a;103=a;41=w;110=a
+1760428869.924736 homie/wall/control/status/set a0a0awaa0aaaaa00aaaaaaaaaa0aawaaaaawawaaawaaaawaawaawaaaaaaaaaaaaaaaaawaaaaaa00aaawaaa0aaaaaaaaaaaaaaaaaaaaaa0aaawaaaaaaa0aaaaaawaaaaa0aaaaaaaaa
+1760428870.199949 homie/wall/control/status/set 134=a@4
+1760428870.264618 homie/wall/control/status/set g2=w@30
+1760428870.501933 homie/wall/control/status/set 81=a;58=x;94=a
+1760428871.593365 homie/wall/control/status/set 10=a
+1760428872.095395 homie/wall/control/status/set aaaaaaaa00aaaaaaaaaaaaaaaa0waaaaawaaaaaaaaaaa0a0aaawawaawaa00aaa0a00aaaaaawaaaaaa0aw0aawa0aaaaaaawaaaaawaaawaaw0aw00aaaaawwwawaaawaa0aaaa0aaaaaa
+1760428872.104567 homie/wall/control/status/set aaaaaaa0a0aaaaaaaaaawwaaa0aaawa0aaaaaaaa0aaaaaaaaawaaa0awaaaaaaawaaaaa00aaaaaa0waaawaaa00aaaaaa0aaaaaa0aaaaaa0aaaaaaawaa00w0aawaaa0aaaaaaaaawaaw
+1760428872.859182 homie/wall/control/status/set 86=a;82=a;123=a;128=a;94=a;62=a
+1760428874.176850 homie/wall/control/status/set g2=a@20
+1760428874.681458 homie/wall/control/status/set 16=a;36=a
+1760428874.855764 homie/wall/control/status/set aaa0a0aa0aaaaaaaaaawaaaaaaaaaa0awaaaaa0aaa0aaaaawaaaaaaaaa0aaaaaa0aa0aaaaaa0aaa0aaaaaaawaaaaaw0wa00aa0aaaawawaawwaaaawaaaaaaaa0aaawwawaa0aaaawaa
+1760428875.759095 homie/wall/control/status/set 54=a;88=a;99=a;117=a
+1760428876.406431 homie/wall/control/status/set 102=w;89=a;15=a;58=a;96=a;104=a
+1760428877.147635 homie/wall/control/status/set 52=a;83=a;108=0
+1760428877.294109 homie/wall/control/status/set aaaaaaaaaaaaa00aa0aaaaaaaaaaaaaaaawaaaaaaaaaaa0aaaaaw0a0aaaaaaaaaawaaaawawwawaaaaaaaaaaaaaaawaawaaaaaawawaaaaaawaaaaaaaaa0wa0aaaaa0aaawaawaa0aaa
+1760428877.722277 homie/wall/control/status/set aaaaaawa0aawa0aaaaw0a0aaawawawaaaaaaaaaaaaaaaaaaaawwaaaaaaaaaaawaaaaawa0awaaaawaa0aa0aawaaaaaaawaaaaaa0aaaaaaaaa0aaaa0a0a0aaaaaaaaawaaaa00aaaaaa
+1760428879.048566 homie/wall/control/status/set 34=a;131=w;2=x;59=a
+1760428880.608987 homie/wall/control/status/set 99=a;117=a;30=a
+1760428881.116802 homie/wall/control/status/set 22=a;55=a;116=0;14=a
+1760428881.596409 homie/wall/control/status/set g3=a@20
+1760428882.614877 homie/wall/control/status/set ?
+1760428882.709238 homie/wall/control/status/set 1=a;47=a;137=a;70=w;133=a
+1760428883.363544 homie/wall/control/status/set 130=a;107=a;13=w;78=w
+1760428884.528986 homie/wall/control/status/set 33=a;13=x
+1760428885.162754 homie/wall/control/status/set 125=a@4
+1760428885.435921 homie/wall/control/status/set 116=a
+1760428885.438589 homie/wall/control/status/set 13=a
+1760428885.440532 homie/wall/control/status/set 136=w
+1760428885.442759 homie/wall/control/status/set 82=w
+1760428885.444580 homie/wall/control/status/set 112=x
+1760428885.446181 homie/wall/control/status/set 53=a
+1760428885.449013 homie/wall/control/status/set 103=a
+1760428885.451348 homie/wall/control/status/set 52=w
+1760428885.452888 homie/wall/control/status/set 31=w
+1760428885.454299 homie/wall/control/status/set 18=a
+1760428885.456791 homie/wall/control/status/set 3=a
+1760428886.403681 homie/wall/control/status/set 75=x;54=a;136=0;40=a;37=a;52=a
+1760428888.211663 homie/wall/control/status/set 65=a;113=a;108=0;39=a;14=a;34=a
+1760428888.948093 homie/wall/control/status/set g2=a@20
+1760428889.425508 homie/wall/control/status/set 59=a;100=a;8=x;83=a;97=a;39=0
+1760428889.522259 homie/wall/control/status/set 102=a;29=a;9=a
+1760428890.000000 homie/wall/config/effect/set x=none;w=none
+1760428891.500000 homie/wall/config/fade-time/set =1400
+1760428892.854737 homie/wall/control/status/set 134=a@3
+1760428893.060872 homie/wall/control/status/set 23=a;51=x;124=a;71=a
+1760428893.151162 homie/wall/control/status/set 76=a;8=a
+1760428893.404392 homie/wall/control/status/set 76=a@2
+1760428893.517623 homie/wall/control/status/set 63=a;84=a;93=a;45=x
+1760428893.881786 homie/wall/control/status/set g1=a@30
+1760428894.181582 homie/wall/control/status/set 131=a
+1760428894.501230 homie/wall/control/status/set g2=w@20
+1760428894.548807 homie/wall/control/status/set g3=a@20
+1760428894.660386 homie/wall/control/status/set 84=a@2
+1760428895.768608 homie/wall/control/status/set ?
+1760428896.161249 homie/wall/control/status/set 27=a
+1760428896.235955 homie/wall/control/status/set 138=a;30=x;83=a;119=x;62=a
+1760428896.510231 homie/wall/control/status/set 142=x;52=x;32=a;61=a
+1760428896.519367 homie/wall/control/status/set 125=a@5
+1760428897.220065 homie/wall/control/status/set 39=a;67=w
+1760428897.519865 homie/wall/control/status/set 30=a;21=a;55=x
+1760428898.264227 homie/wall/control/status/set 18=a;86=a
+1760428898.409393 homie/wall/control/status/set 77=x
+1760428898.410645 homie/wall/control/status/set 118=a
+1760428898.414407 homie/wall/control/status/set 2=x
+1760428898.418228 homie/wall/control/status/set 105=x
+1760428898.419325 homie/wall/control/status/set 62=w
+1760428898.422526 homie/wall/control/status/set 42=w
+1760428898.425920 homie/wall/control/status/set 35=w
+1760428898.427514 homie/wall/control/status/set 56=a
+1760428898.429507 homie/wall/control/status/set 17=w
+1760428898.432882 homie/wall/control/status/set 122=w
+1760428899.315856 homie/wall/control/status/set 16=a@5
+)";